@@ -0,0 +1,280 @@
+/*
+ *  @file   sim.c
+ *
+ *  @brief  Host stand-ins for the PIC32 registers and peripheral library
+ *          calls the TFT driver uses. See sim.h.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include <xc.h>
+#include <plib.h>
+#include "sim.h"
+
+#define CMD_CASET   0x2A
+#define CMD_PASET   0x2B
+#define CMD_RAMWR   0x2C
+
+#define PIN_CS      (1 << 8)
+#define PIN_DC      (1 << 9)
+
+unsigned _sysclk = 40000000, _pbclk = 40000000;
+
+volatile __SPI1STATbits_t SPI1STATbits = { .SPITBE = 1, .SPIRBE = 1,
+                                           .SRMT = 1 };
+volatile unsigned SPI1STATCLR, SPI1BRG, SPI1BUF;
+volatile __LATBbits_t LATBbits;
+volatile __TRISBbits_t TRISBbits;
+volatile __PORTBbits_t PORTBbits;
+volatile __IFS0bits_t IFS0bits;
+volatile unsigned TRISBSET, TRISASET, ANSELACLR, INTCONSET;
+
+unsigned short sim_panel[SIM_HEIGHT][SIM_WIDTH];
+unsigned char sim_args[256][4];
+unsigned long sim_words, sim_pixels, sim_errors;
+unsigned long sim_dma_blocks, sim_dma_max_block;
+unsigned long long sim_ticks;
+unsigned long sim_te_period, sim_te_pulse;
+int sim_failures;
+
+static unsigned latb = PIN_CS;  // CS idles high
+static unsigned spi1con;
+
+// A store to a SET/CLR register lands in `pending`; it takes effect on
+// the next call into the simulator.
+static volatile unsigned pending;
+static int pending_reg = -1;
+
+// Controller state
+static unsigned char cmd;
+static unsigned char args[4];
+static int nargs;
+static short col0, col1, page0, page1, cur_x, cur_y;
+static int have_hi;
+static unsigned char hi;
+
+// DMA channel state
+static const unsigned short *dma_src;
+static unsigned long dma_cells;
+static int dma_enabled, dma_started;
+
+void tft_dmaHandler(void);
+
+static void sim_flush(void) {
+    switch (pending_reg) {
+        case SIM_LATBSET:       latb |= pending;        break;
+        case SIM_LATBCLR:       latb &= ~pending;       break;
+        case SIM_SPI1CONSET:    spi1con |= pending;     break;
+        case SIM_SPI1CONCLR:    spi1con &= ~pending;    break;
+    }
+    pending_reg = -1;
+}
+
+volatile unsigned *sim_sfr(int reg) {
+    sim_flush();
+    pending_reg = reg;
+    pending = 0;
+    return &pending;
+}
+
+static void sim_pixel(unsigned short color) {
+    if ((cur_x < 0) || (cur_x >= SIM_WIDTH) ||
+        (cur_y < 0) || (cur_y >= SIM_HEIGHT))
+        sim_errors++;
+    else
+        sim_panel[cur_y][cur_x] = color;
+    sim_pixels++;
+    if (++cur_x > col1) {
+        cur_x = col0;
+        if (++cur_y > page1)
+            cur_y = page0;
+    }
+}
+
+static void sim_byte(unsigned char b) {
+    if (!(latb & PIN_DC)) {
+        cmd = b;
+        nargs = 0;
+        have_hi = 0;
+        if (cmd == CMD_RAMWR) {
+            cur_x = col0;
+            cur_y = page0;
+        }
+        return;
+    }
+
+    if (nargs < 4)
+        sim_args[cmd][nargs] = b;
+
+    switch (cmd) {
+        case CMD_CASET:
+        case CMD_PASET:
+            if (nargs == 4)
+                break;
+            args[nargs++] = b;
+            if (nargs < 4)
+                break;
+            if (cmd == CMD_CASET) {
+                col0 = (args[0] << 8) | args[1];
+                col1 = (args[2] << 8) | args[3];
+            } else {
+                page0 = (args[0] << 8) | args[1];
+                page1 = (args[2] << 8) | args[3];
+            }
+            break;
+        case CMD_RAMWR:
+            if (have_hi)
+                sim_pixel((hi << 8) | b);
+            else
+                hi = b;
+            have_hi = !have_hi;
+            break;
+        default:
+            if (nargs < 4)
+                nargs++;
+            break;
+    }
+}
+
+// One SPI1 frame, 8, 16 or 32 bits wide as SPI1CON says, MSB first
+static void sim_word(unsigned long w) {
+    sim_flush();
+    sim_words++;
+    if (latb & PIN_CS) {
+        sim_errors++;
+        return;
+    }
+    if (spi1con & 0x800) {
+        sim_byte(w >> 24);
+        sim_byte(w >> 16);
+    }
+    if (spi1con & 0xC00)
+        sim_byte(w >> 8);
+    sim_byte(w);
+}
+
+/**
+ *  Fills the panel with `color`, zeroes the counters and finishes any
+ *  DMA transfer left over from the previous test.
+ */
+void sim_reset(unsigned short color) {
+    int x, y;
+
+    sim_dmaRun();
+    for (y = 0; y < SIM_HEIGHT; y++)
+        for (x = 0; x < SIM_WIDTH; x++)
+            sim_panel[y][x] = color;
+    sim_words = sim_pixels = sim_errors = 0;
+    sim_dma_blocks = sim_dma_max_block = 0;
+}
+
+/**
+ *  Returns the level of the CS line.
+ */
+int sim_cs(void) {
+    sim_flush();
+    return (latb & PIN_CS) != 0;
+}
+
+/**
+ *  Returns nonzero if the DMA channel has been started and hasn't yet
+ *  moved its block.
+ */
+int sim_dmaPending(void) {
+    return dma_started;
+}
+
+/**
+ *  Lets the DMA channel run: moves each block into SPI1BUF and raises the
+ *  block-done interrupt, until the driver stops starting new blocks.
+ */
+void sim_dmaRun(void) {
+    unsigned long i;
+
+    while (dma_started) {
+        dma_started = dma_enabled = 0;
+        if ((spi1con & 0xC00) != 0x400)  // DMA cells are 16-bit pixels
+            sim_errors++;
+        for (i = 0; i < dma_cells; i++)
+            sim_word(dma_src[i]);
+        sim_dma_blocks++;
+        if (dma_cells > sim_dma_max_block)
+            sim_dma_max_block = dma_cells;
+        tft_dmaHandler();
+    }
+}
+
+/**
+ *  Moves simulated time forward by the given number of core timer ticks,
+ *  as if the CPU were busy drawing.
+ */
+void sim_advance(unsigned long ticks) {
+    sim_ticks += ticks;
+}
+
+/**
+ *  Returns the level of the TE pin: high for the first sim_te_pulse
+ *  ticks of every sim_te_period, and always low if sim_te_period is 0.
+ *  Each read takes SIM_READ_TICKS.
+ */
+int sim_te(void) {
+    sim_ticks += SIM_READ_TICKS;
+    return sim_te_period && (sim_ticks % sim_te_period < sim_te_pulse);
+}
+
+unsigned ReadCoreTimer(void) {
+    sim_ticks += SIM_READ_TICKS;
+    return sim_ticks;
+}
+
+void SpiChnOpen(int chn, unsigned config, unsigned div) {
+    sim_flush();
+    spi1con = 0;    // SPI_OPEN_MODE8
+}
+
+int TxBufFullSPI1(void) {
+    return 0;
+}
+
+void WriteSPI1(unsigned data) {
+    sim_word(data);
+}
+
+unsigned ReadSPI1(void) {
+    return 0;
+}
+
+void INTSetVectorPriority(int vector, int priority) { }
+void INTSetVectorSubPriority(int vector, int subpriority) { }
+void INTClearFlag(int source) { }
+void INTEnable(int source, int enable) { }
+
+unsigned INTDisableInterrupts(void) {
+    return 0;
+}
+
+void INTRestoreInterrupts(unsigned status) { }
+
+void DmaChnOpen(int chn, int priority, int flags) { }
+void DmaChnSetEventControl(int chn, int flags) { }
+void DmaChnSetEvEnableFlags(int chn, int flags) { }
+void DmaChnClrEvFlags(int chn, int flags) { }
+
+void DmaChnSetTxfer(int chn, const void *src, void *dst, int srcSize,
+                    int dstSize, int cellSize) {
+    if ((dst != (void *)&SPI1BUF) || (dstSize != 2) || (cellSize != 2) ||
+        (srcSize <= 0) || (srcSize & 1))
+        sim_errors++;
+    dma_src = src;
+    dma_cells = srcSize / 2;
+}
+
+void DmaChnEnable(int chn) {
+    dma_enabled = 1;
+}
+
+void DmaChnStartTxfer(int chn, int wait, unsigned long timeout) {
+    if (!dma_enabled || dma_started)
+        sim_errors++;
+    dma_started = 1;
+}
@@ -0,0 +1,61 @@
+/*
+ *  @file   sim.h
+ *
+ *  @brief  Host simulation of the TFT's hardware for the tests in this
+ *          directory: an ILI9340 on SPI1, fed by the CPU or by DMA.
+ *
+ *          Every word written to SPI1 (by WriteSPI1() or by the simulated
+ *          DMA channel) is decoded like the controller does, using the
+ *          current D/C line and SPI1 frame size, so CASET/PASET/RAMWR
+ *          land pixels in sim_panel[][]. Words sent with CS high, pixels
+ *          outside the panel and DMA transfers that don't target SPI1BUF
+ *          are counted in sim_errors.
+ *
+ *          A DMA transfer started by the driver doesn't move any data
+ *          until the test calls sim_dmaRun(), so a test can see what the
+ *          CPU did before the hardware took over.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdio.h>
+
+#define SIM_WIDTH   240
+#define SIM_HEIGHT  320
+
+extern unsigned short sim_panel[SIM_HEIGHT][SIM_WIDTH];
+extern unsigned char sim_args[256][4];  // first argument bytes of each command
+
+extern unsigned long sim_words;     // SPI words sent, by the CPU or DMA
+extern unsigned long sim_pixels;    // pixels stored by RAMWR
+extern unsigned long sim_errors;
+extern unsigned long sim_dma_blocks;    // DMA blocks completed
+extern unsigned long sim_dma_max_block; // largest DMA block, in pixels
+
+// Simulated time, in core timer ticks (SYSCLK/2). Reading the core timer
+// or the TE pin takes SIM_READ_TICKS.
+#define SIM_READ_TICKS  100
+extern unsigned long long sim_ticks;
+extern unsigned long sim_te_period, sim_te_pulse;   // see sim_te()
+
+void sim_reset(unsigned short color);
+int sim_cs(void);
+int sim_dmaPending(void);
+void sim_dmaRun(void);
+void sim_advance(unsigned long ticks);
+
+// Test bookkeeping shared by the test programs
+extern int sim_failures;
+
+#define CHECK(cond) do {                                            \
+        if (!(cond)) {                                              \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+                   #cond);                                          \
+            sim_failures++;                                         \
+        }                                                           \
+    } while (0)
+
+#endif // SIM_H
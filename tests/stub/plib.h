@@ -0,0 +1,67 @@
+/*
+ *  @file   plib.h
+ *
+ *  @brief  Host stand-in for the PIC32 peripheral library: the SPI, DMA,
+ *          interrupt and core timer calls the TFT driver makes. See sim.c.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#ifndef SIM_PLIB_H
+#define SIM_PLIB_H
+
+#include <xc.h>
+
+unsigned ReadCoreTimer(void);
+#define mCTClearIntFlag()   ((void)0)
+
+#define SPI_OPEN_MSTEN          0x0020
+#define SPI_OPEN_CKE_REV        0x0100
+#define SPI_OPEN_MODE8          0x0000
+#define SPI_OPEN_ON             0x8000
+#define SPI_OPEN_ENHBUF         0x10000
+#define SPI_OPEN_TBE_NOT_FULL   0x0C
+void SpiChnOpen(int chn, unsigned config, unsigned div);
+int TxBufFullSPI1(void);
+void WriteSPI1(unsigned data);
+unsigned ReadSPI1(void);
+#define PPSOutput(grp, pin, fn) ((void)0)
+#define PPSInput(grp, fn, pin)  ((void)0)
+
+#define INT_ENABLED                 1
+#define INT_PRIORITY_LEVEL_4        4
+#define INT_PRIORITY_LEVEL_5        5
+#define INT_PRIORITY_LEVEL_6        6
+#define INT_SUB_PRIORITY_LEVEL_0    0
+#define INT_CORE_TIMER_VECTOR       0
+#define INT_EXTERNAL_0_VECTOR       3
+#define INT_CT                      0
+#define INT_INT0                    3
+#define INT_VECTOR_DMA(chn)         (36 + (chn))
+#define INT_SOURCE_DMA(chn)         (60 + (chn))
+void INTSetVectorPriority(int vector, int priority);
+void INTSetVectorSubPriority(int vector, int subpriority);
+void INTClearFlag(int source);
+void INTEnable(int source, int enable);
+unsigned INTDisableInterrupts(void);
+void INTRestoreInterrupts(unsigned status);
+
+#define _SPI1_TX_IRQ            37
+#define DMA_CHANNEL3            3
+#define DMA_CHN_PRI3            3
+#define DMA_OPEN_DEFAULT        0
+#define DMA_EV_START_IRQ_EN     0x10
+#define DMA_EV_START_IRQ(irq)   ((irq) << 8)
+#define DMA_EV_BLOCK_DONE       0x08
+#define DMA_EV_ALL_EVNTS        0xFF
+#define DMA_WAIT_NOT            0
+void DmaChnOpen(int chn, int priority, int flags);
+void DmaChnSetEventControl(int chn, int flags);
+void DmaChnSetEvEnableFlags(int chn, int flags);
+void DmaChnSetTxfer(int chn, const void *src, void *dst, int srcSize,
+                    int dstSize, int cellSize);
+void DmaChnEnable(int chn);
+void DmaChnStartTxfer(int chn, int wait, unsigned long timeout);
+void DmaChnClrEvFlags(int chn, int flags);
+
+#endif // SIM_PLIB_H
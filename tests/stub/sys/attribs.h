@@ -0,0 +1,15 @@
+/*
+ *  @file   attribs.h
+ *
+ *  @brief  Host stand-in for <sys/attribs.h>. Interrupt handlers become
+ *          plain functions, which the simulator calls directly.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#ifndef SIM_ATTRIBS_H
+#define SIM_ATTRIBS_H
+
+#define __ISR(vector, ipl)
+
+#endif // SIM_ATTRIBS_H
@@ -0,0 +1,47 @@
+/*
+ *  @file   xc.h
+ *
+ *  @brief  Host stand-in for the XC32 device header: just the special
+ *          function registers the TFT driver touches. See sim.c.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#ifndef SIM_XC_H
+#define SIM_XC_H
+
+typedef struct {
+    unsigned SPIRBF:1, SPITBF:1, :1, SPITBE:1, :1, SPIRBE:1, SPIROV:1,
+             SRMT:1, :3, SPIBUSY:1;
+} __SPI1STATbits_t;
+extern volatile __SPI1STATbits_t SPI1STATbits;
+extern volatile unsigned SPI1STATCLR, SPI1BRG, SPI1BUF;
+#define _SPI1STAT_SPIROV_MASK   0x40
+
+typedef struct { unsigned :2, LATB2:1, :5, LATB8:1, LATB9:1; } __LATBbits_t;
+extern volatile __LATBbits_t LATBbits;
+typedef struct { unsigned :2, TRISB2:1, :5, TRISB8:1, TRISB9:1; } __TRISBbits_t;
+extern volatile __TRISBbits_t TRISBbits;
+typedef struct { unsigned :7, RB7:1; } __PORTBbits_t;
+extern volatile __PORTBbits_t PORTBbits;
+typedef struct { unsigned CTIF:1; } __IFS0bits_t;
+extern volatile __IFS0bits_t IFS0bits;
+extern volatile unsigned TRISBSET, TRISASET, ANSELACLR, INTCONSET;
+#define _INTCON_INT0EP_MASK     1
+
+// Writes to these take effect in the simulated hardware (D/C, CS and the
+// SPI1 frame size), so they go through sim_sfr().
+enum { SIM_LATBSET, SIM_LATBCLR, SIM_SPI1CONSET, SIM_SPI1CONCLR };
+volatile unsigned *sim_sfr(int reg);
+#define LATBSET     (*sim_sfr(SIM_LATBSET))
+#define LATBCLR     (*sim_sfr(SIM_LATBCLR))
+#define SPI1CONSET  (*sim_sfr(SIM_SPI1CONSET))
+#define SPI1CONCLR  (*sim_sfr(SIM_SPI1CONCLR))
+
+#define _CP0_SET_COMPARE(x) ((void)(x))
+
+// Level of the TE pin, for building tft_sync.c with TFT_SYNC_POLLED and
+// TFT_TE_READ() defined as sim_te()
+int sim_te(void);
+
+#endif // SIM_XC_H
@@ -0,0 +1,87 @@
+/*
+ *  @file   test_console.c
+ *
+ *  @brief  Host test for tft_console.c: margins and sizes that leave no
+ *          room for a line of text are reduced to fit one, instead of
+ *          leaving the console with zero rows or columns, and SGR
+ *          sequences with several arguments apply each of them.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include "sim.h"
+#include "tft_master.h"
+#include "tft_console.h"
+#include "timebase.h"
+
+#define FG      0xFFFF
+#define BG      0x0000
+
+// Returns the number of panel pixels in rows y0 to y1 that are not `bg`
+static long count_ink(short y0, short y1) {
+    long x, y, n = 0;
+
+    for (y = y0; y <= y1; y++)
+        for (x = 0; x < SIM_WIDTH; x++)
+            n += sim_panel[y][x] != BG;
+    return n;
+}
+
+// Returns the number of panel pixels that are `color`
+static long count_color(unsigned short color) {
+    long x, y, n = 0;
+
+    for (y = 0; y < SIM_HEIGHT; y++)
+        for (x = 0; x < SIM_WIDTH; x++)
+            n += sim_panel[y][x] == color;
+    return n;
+}
+
+static void test_margins(void) {
+    sim_reset(0x1234);
+    tft_consoleInit(300, 30, 1, FG, BG);
+    tft_consoleWrite("one\ntwo\nthree");
+    CHECK(count_ink(0, 299) == 300L * SIM_WIDTH);
+    CHECK(count_ink(300, 307) > 0);
+    CHECK(sim_errors == 0);
+
+    sim_reset(0x1234);
+    tft_consoleInit(400, -5, 2, FG, BG);
+    tft_consoleWrite("x\ny");
+    CHECK(count_ink(304, 319) > 0);
+    CHECK(sim_errors == 0);
+
+    sim_reset(0x1234);
+    tft_consoleInit(0, 0, 255, FG, BG);
+    tft_consoleWrite("MW\nM");
+    CHECK(sim_errors == 0);
+}
+
+static void test_sgr(void) {
+    sim_reset(0x1234);
+    tft_consoleInit(0, 0, 1, FG, BG);
+    tft_consoleWrite("\x1b[0;31;44mX");
+    CHECK(count_color(ILI9340_RED) > 0);
+    CHECK(count_color(ILI9340_BLUE) > 0);
+    CHECK(count_color(FG) == 0);
+
+    // arguments past the fourth are dropped, not folded into another
+    sim_reset(0x1234);
+    tft_consoleInit(0, 0, 1, FG, BG);
+    tft_consoleWrite("\x1b[0;32;40;1;35;45mX");
+    CHECK(count_color(ILI9340_GREEN) > 0);
+    CHECK(count_color(ILI9340_MAGENTA) == 0);
+    CHECK(count_color(FG) == 0);
+    CHECK(sim_errors == 0);
+}
+
+int main(void) {
+    timebase_init();
+    tft_init();
+
+    test_margins();
+    test_sgr();
+
+    printf("test_console: %s\n", sim_failures ? "FAILED" : "ok");
+    return sim_failures != 0;
+}
@@ -0,0 +1,180 @@
+/*
+ *  @file   test_dma.c
+ *
+ *  @brief  Host test for tft_dma.c: the DMA fills and blits reach the
+ *          panel intact, leave the CPU free until the transfer runs, and
+ *          release SPI1 and call back exactly once when done.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include "sim.h"
+#include "tft_master.h"
+#include "tft_dma.h"
+#include "timebase.h"
+
+#define BG      0x0000
+#define RED     0xF800
+#define BLUE    0x001F
+
+static unsigned short image[240 * 200];
+static int done_count, done_cs, done_busy;
+
+static void done(void) {
+    done_count++;
+    done_cs = sim_cs();
+    done_busy = tft_dmaBusy();
+}
+
+// Returns the number of panel pixels in (x, y, w, h) that aren't `color`,
+// plus the number outside it that aren't `bg`.
+static long count_wrong(short x, short y, short w, short h,
+                        unsigned short color, unsigned short bg) {
+    int i, j, inside;
+    long wrong = 0;
+
+    for (j = 0; j < SIM_HEIGHT; j++)
+        for (i = 0; i < SIM_WIDTH; i++) {
+            inside = (i >= x) && (i < x + w) && (j >= y) && (j < y + h);
+            if (sim_panel[j][i] != (inside ? color : bg))
+                wrong++;
+        }
+    return wrong;
+}
+
+static void start(void) {
+    sim_reset(BG);
+    done_count = done_cs = done_busy = 0;
+}
+
+static void test_fill(void) {
+    start();
+    tft_fillRectDMA(10, 20, 100, 50, RED, done);
+    // Only the window has been sent; the pixels are up to the DMA channel
+    CHECK(tft_dmaBusy());
+    CHECK(sim_dmaPending());
+    CHECK(sim_pixels == 0);
+    CHECK(sim_cs() == 0);
+    CHECK(done_count == 0);
+
+    sim_dmaRun();
+    CHECK(done_count == 1);
+    CHECK(done_cs == 1);
+    CHECK(done_busy == 0);
+    CHECK(sim_cs() == 1);
+    CHECK(sim_pixels == 100 * 50);
+    CHECK(sim_dma_blocks == (100 * 50 + 511) / 512);
+    CHECK(sim_dma_max_block == 512);
+    CHECK(count_wrong(10, 20, 100, 50, RED, BG) == 0);
+    CHECK(sim_errors == 0);
+
+    // A whole screen takes one interrupt per 512 pixels
+    start();
+    tft_fillScreenDMA(BLUE, done);
+    sim_dmaRun();
+    CHECK(done_count == 1);
+    CHECK(sim_dma_blocks == 240 * 320 / 512);
+    CHECK(count_wrong(0, 0, 240, 320, BLUE, BG) == 0);
+
+    // Smaller than a block
+    start();
+    tft_fillRectDMA(3, 4, 5, 6, RED, done);
+    sim_dmaRun();
+    CHECK(sim_dma_blocks == 1);
+    CHECK(count_wrong(3, 4, 5, 6, RED, BG) == 0);
+    CHECK(sim_errors == 0);
+}
+
+static void test_fillClipped(void) {
+    start();
+    tft_fillRectDMA(-10, 300, 50, 50, BLUE, done);
+    sim_dmaRun();
+    CHECK(done_count == 1);
+    CHECK(sim_pixels == 40 * 20);
+    CHECK(count_wrong(0, 300, 40, 20, BLUE, BG) == 0);
+
+    start();
+    tft_pushClip(50, 50, 20, 10);
+    tft_fillScreenDMA(RED, done);
+    sim_dmaRun();
+    tft_popClip();
+    CHECK(done_count == 1);
+    CHECK(count_wrong(50, 50, 20, 10, RED, BG) == 0);
+
+    // Off screen: the callback comes right away and nothing is sent
+    start();
+    tft_fillRectDMA(240, 0, 10, 10, RED, done);
+    CHECK(done_count == 1);
+    CHECK(!tft_dmaBusy());
+    CHECK(!sim_dmaPending());
+    CHECK(sim_words == 0);
+    CHECK(sim_errors == 0);
+}
+
+static void test_blit(void) {
+    long i, wrong = 0;
+    int x, y;
+
+    for (i = 0; i < 240 * 200; i++)
+        image[i] = i * 2654435761UL >> 16;
+
+    // 48000 pixels take two blocks
+    start();
+    tft_writeRectDMA(0, 60, 240, 200, image, done);
+    CHECK(tft_dmaBusy());
+    CHECK(sim_pixels == 0);
+    sim_dmaRun();
+    CHECK(done_count == 1);
+    CHECK(sim_dma_blocks == 2);
+    CHECK(sim_dma_max_block == 32767);
+    CHECK(sim_pixels == 240 * 200);
+    for (y = 0; y < 200; y++)
+        for (x = 0; x < 240; x++)
+            wrong += sim_panel[60 + y][x] != image[y * 240 + x];
+    CHECK(wrong == 0);
+    CHECK(sim_errors == 0);
+
+    // Partly off screen: sent by the CPU, only the visible part
+    start();
+    tft_writeRectDMA(-5, -5, 20, 20, image, done);
+    CHECK(done_count == 1);
+    CHECK(!tft_dmaBusy());
+    CHECK(!sim_dmaPending());
+    CHECK(sim_pixels == 15 * 15);
+    wrong = 0;
+    for (y = 0; y < 15; y++)
+        for (x = 0; x < 15; x++)
+            wrong += sim_panel[y][x] != image[(y + 5) * 20 + x + 5];
+    CHECK(wrong == 0);
+    CHECK(sim_errors == 0);
+}
+
+// Drawing by the CPU after a transfer must not trust a stale write
+// position.
+static void test_afterDMA(void) {
+    start();
+    tft_fillRectDMA(0, 0, 240, 2, RED, done);
+    sim_dmaRun();
+    tft_drawPixel(5, 1, BLUE);
+    tft_fillRect(0, 2, 3, 1, BLUE);
+    CHECK(sim_panel[1][5] == BLUE);
+    CHECK(sim_panel[1][4] == RED);
+    CHECK(sim_panel[2][0] == BLUE);
+    CHECK(sim_panel[2][2] == BLUE);
+    CHECK(sim_panel[2][3] == BG);
+    CHECK(sim_errors == 0);
+}
+
+int main(void) {
+    timebase_init();
+    tft_init();
+    CHECK(sim_errors == 0);
+
+    test_fill();
+    test_fillClipped();
+    test_blit();
+    test_afterDMA();
+
+    printf("test_dma: %s\n", sim_failures ? "FAILED" : "ok");
+    return sim_failures != 0;
+}
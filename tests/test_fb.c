@@ -0,0 +1,84 @@
+/*
+ *  @file   test_fb.c
+ *
+ *  @brief  Host test for tft_fb.c: a flush while drawing is redirected
+ *          reaches the whole placed and scaled area of the display, and
+ *          reads while redirected come from the framebuffer.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include "sim.h"
+#include "tft_master.h"
+#include "tft_fb.h"
+#include "timebase.h"
+
+#define BG      0x0000
+#define RED     0xF800
+#define BLUE    0x001F
+
+static const unsigned short palette[4] = { BG, RED, BLUE, 0xFFFF };
+static unsigned char fb[TFT_FB_BYTES(100, 80, 2)];
+
+static void test_scaledFlush(void) {
+    long x, y, wrong = 0;
+    unsigned short want;
+
+    sim_reset(BG);
+    tft_fbInit(fb, 100, 80, 2, palette);
+    tft_fbPlace(20, 30, 2);
+    tft_fbBegin();
+    CHECK(_width == 100);
+    CHECK(_height == 80);
+    tft_fillRect(0, 0, 100, 80, RED);
+    tft_fillRect(90, 70, 10, 10, BLUE);    // bottom right corner
+    tft_pushClip(0, 0, 10, 10);             // must not limit the flush
+    tft_fbFlush();
+    tft_popClip();
+    tft_fbEnd();
+
+    for (y = 0; y < SIM_HEIGHT; y++)
+        for (x = 0; x < SIM_WIDTH; x++) {
+            want = BG;
+            if ((x >= 20) && (x < 220) && (y >= 30) && (y < 190))
+                want = ((x >= 200) && (y >= 170)) ? BLUE : RED;
+            wrong += sim_panel[y][x] != want;
+        }
+    CHECK(wrong == 0);
+    CHECK(sim_pixels == 200 * 160);
+    CHECK(_width == 240);
+    CHECK(sim_errors == 0);
+}
+
+// Reads while redirected come from the framebuffer, not the panel
+static void test_read(void) {
+    unsigned short buf[6];
+
+    sim_reset(0xFFFF);
+    tft_fbInit(fb, 100, 80, 2, palette);
+    tft_fbBegin();
+    tft_drawPixel(4, 7, RED);
+    tft_drawPixel(5, 8, BLUE);
+    tft_readRect(4, 7, 3, 2, buf);
+    CHECK(buf[0] == RED);
+    CHECK(buf[1] == BG);
+    CHECK(buf[4] == BLUE);
+    CHECK(tft_readPixel(5, 8) == BLUE);
+    CHECK(tft_readPixel(99, 79) == BG);
+    tft_pushViewport(4, 7, 10, 10);
+    CHECK(tft_readPixel(1, 1) == BLUE);
+    tft_popClip();
+    tft_fbEnd();
+    CHECK(sim_words == 0);  // nothing was read from the panel
+}
+
+int main(void) {
+    timebase_init();
+    tft_init();
+
+    test_scaledFlush();
+    test_read();
+
+    printf("test_fb: %s\n", sim_failures ? "FAILED" : "ok");
+    return sim_failures != 0;
+}
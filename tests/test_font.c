@@ -0,0 +1,56 @@
+/*
+ *  @file   test_font.c
+ *
+ *  @brief  Host test for tft_font.c: full coverage draws exactly the text
+ *          color and zero coverage exactly the background, whichever of
+ *          the two is darker.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include "sim.h"
+#include "tft_master.h"
+#include "tft_font.h"
+#include "timebase.h"
+
+// One glyph, 'A': a 2x1 bitmap of full then zero coverage, in a 3-pixel
+// cell, so the cell's padding is background too.
+static const struct tft_glyph glyphs[] = { { 0, 2, 1, 0, 0, 3 } };
+static const unsigned char data4[] = { 0x0F, 0x00 };
+static const unsigned char data2[] = { 0x03, 0x00 };
+static const struct tft_font font4 = { 4, 'A', 'A', 1, 1, glyphs, data4 };
+static const struct tft_font font2 = { 2, 'A', 'A', 1, 1, glyphs, data2 };
+
+static void test_ends(void) {
+    static const unsigned short colors[] = {
+        0x0000, 0xFFFF, 0xF800, 0x07E0, 0x001F, 0x1234, 0x8410, 0x0841,
+        0xFFDF, 0x7BEF
+    };
+    int i, j, n = sizeof colors / sizeof colors[0];
+    long wrong = 0;
+
+    sim_reset(0);
+    for (i = 0; i < n; i++)
+        for (j = 0; j < n; j++) {
+            tft_fontDrawText(0, 0, "A", &font4, colors[i], colors[j]);
+            tft_fontDrawText(0, 1, "A", &font2, colors[i], colors[j]);
+            wrong += (sim_panel[0][0] != colors[i]) +
+                     (sim_panel[0][1] != colors[j]) +
+                     (sim_panel[0][2] != colors[j]) +
+                     (sim_panel[1][0] != colors[i]) +
+                     (sim_panel[1][1] != colors[j]) +
+                     (sim_panel[1][2] != colors[j]);
+        }
+    CHECK(wrong == 0);
+    CHECK(sim_errors == 0);
+}
+
+int main(void) {
+    timebase_init();
+    tft_init();
+
+    test_ends();
+
+    printf("test_font: %s\n", sim_failures ? "FAILED" : "ok");
+    return sim_failures != 0;
+}
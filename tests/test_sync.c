@@ -0,0 +1,96 @@
+/*
+ *  @file   test_sync.c
+ *
+ *  @brief  Host test for tft_sync.c, built with TFT_SYNC_POLLED and the TE
+ *          pin driven by sim_te(): tft_waitVSync() returns on each rising
+ *          edge, overruns are counted as missed frames, and
+ *          tft_setFrameRate() picks the closest FRMCTR1 RTNA value.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include "sim.h"
+#include "tft_master.h"
+#include "tft_sync.h"
+#include "timebase.h"
+
+#define CMD_FRMCTR1 0xB1
+
+// 60 Hz with the core timer at 20 MHz, and a 1 ms TE pulse. Measured
+// times are only as fine as SIM_READ_TICKS.
+#define PERIOD      333333
+#define PULSE       20000
+
+// Returns how far past the last TE rising edge simulated time is
+static unsigned long phase(void) {
+    return sim_ticks % PERIOD;
+}
+
+static void test_wait(void) {
+    struct tft_frame_stats st;
+    int i;
+
+    sim_te_period = PERIOD;
+    sim_te_pulse = PULSE;
+    tft_syncInit();
+
+    // Each wait returns just after the next rising edge
+    for (i = 0; i < 5; i++) {
+        tft_waitVSync();
+        CHECK(phase() < 10 * SIM_READ_TICKS);
+        sim_advance(PERIOD / 2);
+    }
+    tft_frameStats(&st);
+    CHECK(st.frames == 5);
+    CHECK(st.missed == 0);
+    CHECK((st.period_us >= 16666) && (st.period_us < 16680));
+    CHECK((st.busy_us >= 8333) && (st.busy_us < 8400));
+
+    // Drawing that runs into the pulse still waits for the next edge
+    tft_waitVSync();
+    sim_advance(PULSE / 2);
+    tft_waitVSync();
+    CHECK(phase() < 10 * SIM_READ_TICKS);
+    tft_frameStats(&st);
+    CHECK(st.missed == 0);
+
+    // 2.5 frames of drawing: two pulses go by unseen
+    sim_advance(5 * PERIOD / 2);
+    tft_waitVSync();
+    CHECK(phase() < 10 * SIM_READ_TICKS);
+    tft_frameStats(&st);
+    CHECK(st.missed == 2);
+    CHECK(st.frames == 10);
+    CHECK((st.period_us >= 16666) && (st.period_us < 16680));
+    CHECK(st.worst_us >= 5 * 16666 / 2);
+
+    sim_te_period = 0;
+}
+
+static void test_frameRate(void) {
+    static const unsigned char hz[] = { 0, 60, 61, 62, 79, 80, 100, 200 };
+    static const unsigned char rtna[] = {
+        0x1F, 0x1F, 0x1F, 0x1E, 0x18, 0x18, 0x13, 0x10
+    };
+    // 62 Hz is as close to 63 as to 61; the faster rate wins
+    static const unsigned char rate[] = { 61, 61, 61, 63, 79, 79, 100, 119 };
+    unsigned i;
+
+    for (i = 0; i < sizeof hz; i++) {
+        CHECK(tft_setFrameRate(hz[i]) == rate[i]);
+        CHECK(sim_args[CMD_FRMCTR1][0] == 0x00);
+        CHECK(sim_args[CMD_FRMCTR1][1] == rtna[i]);
+    }
+    CHECK(sim_errors == 0);
+}
+
+int main(void) {
+    timebase_init();
+    tft_init();
+
+    test_wait();
+    test_frameRate();
+
+    printf("test_sync: %s\n", sim_failures ? "FAILED" : "ok");
+    return sim_failures != 0;
+}
@@ -0,0 +1,110 @@
+/*
+ *  @file   test_text.c
+ *
+ *  @brief  Host test for the built-in 5x7 font in tft_gfx.c: tft_drawChar()
+ *          and tft_drawText() match a pixel-by-pixel rendering of the font
+ *          at every size, including cells much wider than the screen and
+ *          cells that are only partly visible, and lines wider than
+ *          32767 pixels.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include <string.h>
+#include "sim.h"
+#include "tft_master.h"
+#include "tft_gfx.h"
+#include "timebase.h"
+#include "private/glcdfont.h"
+
+#define BG      0x0000  // the panel before drawing
+#define FG      0xFFFF
+#define TEXT_BG 0x1234
+
+// Draws `str` at (x, y) with tft_drawText(), or with tft_drawChar() if it
+// is a single character, over `bg` (FG for a transparent background), and
+// returns the number of panel pixels that differ from the reference.
+static long check_text(long x, long y, const char *str, unsigned char size,
+                       unsigned short bg) {
+    long px, py, col, row, n = strlen(str), wrong = 0;
+    unsigned short want;
+    unsigned char c;
+
+    sim_reset(BG);
+    if (n == 1)
+        tft_drawChar(x, y, str[0], FG, bg, size);
+    else if (tft_drawText(x, y, str, FG, bg, size) !=
+             ((n * 6 * size > 0x7FFF) ? 0x7FFF : n * 6 * size))
+        wrong++;
+
+    for (py = 0; py < SIM_HEIGHT; py++)
+        for (px = 0; px < SIM_WIDTH; px++) {
+            want = BG;
+            col = (px - x) / size;
+            row = (py - y) / size;
+            if ((px >= x) && (py >= y) && (col < 6 * n) && (row < 8) &&
+                (px >= _clip_x0) && (px <= _clip_x1) &&
+                (py >= _clip_y0) && (py <= _clip_y1)) {
+                c = str[col / 6];
+                col %= 6;
+                if ((col < 5) && ((font[c * 5 + col] >> row) & 1))
+                    want = FG;
+                else if (bg != FG)
+                    want = bg;
+            }
+            wrong += sim_panel[py][px] != want;
+        }
+    return wrong + sim_errors;
+}
+
+static void test_sizes(void) {
+    static const unsigned char sizes[] = { 1, 2, 3, 4, 5, 9, 53, 54, 60, 255 };
+    unsigned i;
+
+    unsigned short bg;
+    int k;
+
+    for (k = 0; k < 2; k++) {
+        bg = k ? FG : TEXT_BG;
+        for (i = 0; i < sizeof sizes; i++) {
+            CHECK(check_text(3, 5, "A", sizes[i], bg) == 0);
+            CHECK(check_text(-7 * sizes[i] / 2, -3 * sizes[i], "W", sizes[i],
+                             bg) == 0);
+            CHECK(check_text(-5, 1, "Hi 42!", sizes[i], bg) == 0);
+            CHECK(check_text(-6 * sizes[i] - 2, 7, "x@M", sizes[i], bg) == 0);
+        }
+
+        // Clipped to a small box
+        tft_pushClip(10, 20, 50, 30);
+        CHECK(check_text(0, 15, "A", 60, bg) == 0);
+        CHECK(check_text(5, 15, "Clip", 3, bg) == 0);
+        CHECK(check_text(-100, -40, "Big", 70, bg) == 0);
+        tft_popClip();
+    }
+}
+
+// Lines wider than 32767 pixels, mostly off screen
+static void test_long(void) {
+    static char str[601];
+    int i;
+
+    for (i = 0; i < 600; i++)
+        str[i] = 'A' + i % 26;
+    CHECK(check_text(-32000, 3, str, 10, TEXT_BG) == 0);
+    CHECK(check_text(-32000, 3, str, 10, FG) == 0);
+    CHECK(check_text(100, 3, str, 10, TEXT_BG) == 0);
+    CHECK(check_text(100, 3, str, 10, FG) == 0);
+    str[10] = 0;
+    CHECK(check_text(-32768, 3, str, 255, TEXT_BG) == 0);
+}
+
+int main(void) {
+    timebase_init();
+    tft_init();
+
+    test_sizes();
+    test_long();
+
+    printf("test_text: %s\n", sim_failures ? "FAILED" : "ok");
+    return sim_failures != 0;
+}
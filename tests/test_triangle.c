@@ -0,0 +1,154 @@
+/*
+ *  @file   test_triangle.c
+ *
+ *  @brief  Host test for tft_fillTriangle(): its coverage matches a
+ *          brute-force point-in-triangle test using the top-left rule,
+ *          with and without clipping, and triangles sharing edges cover
+ *          each pixel exactly once.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "tft_master.h"
+#include "tft_gfx.h"
+#include "tft_poly.h"
+#include "timebase.h"
+
+#define BG      0x0000
+#define FG      0xFFFF
+
+// Reference coverage: a pixel is inside if its center (x, y) has a
+// nonzero winding number, counting an edge from (ax, ay) to (bx, by)
+// (ay < by) when ay <= y < by and the edge is at or left of x. So left and
+// top edges are in, right and bottom edges out.
+static int inside(const short *v, long x, long y) {
+    int i, dir, w = 0;
+    long ax, ay, bx, by, t;
+
+    for (i = 0; i < 3; i++) {
+        ax = v[2*i];
+        ay = v[2*i + 1];
+        bx = v[(2*i + 2) % 6];
+        by = v[(2*i + 3) % 6];
+        dir = 1;
+        if (ay == by)
+            continue;
+        if (ay > by) {
+            t = ax; ax = bx; bx = t;
+            t = ay; ay = by; by = t;
+            dir = -1;
+        }
+        if ((y < ay) || (y >= by))
+            continue;
+        if (ax * (by - ay) + (y - ay) * (bx - ax) <= x * (by - ay))
+            w += dir;
+    }
+    return w != 0;
+}
+
+// Draws the triangle and compares every panel pixel with the reference,
+// returning the number that differ. Pixels drawn twice count as well.
+static long check_triangle(const short *v) {
+    long x, y, drawn = 0, wrong = 0;
+    int in;
+
+    sim_reset(BG);
+    tft_fillTriangle(v[0], v[1], v[2], v[3], v[4], v[5], FG);
+    for (y = 0; y < SIM_HEIGHT; y++)
+        for (x = 0; x < SIM_WIDTH; x++) {
+            in = (x >= _clip_x0) && (x <= _clip_x1) &&
+                 (y >= _clip_y0) && (y <= _clip_y1) && inside(v, x, y);
+            drawn += in;
+            wrong += sim_panel[y][x] != (in ? FG : BG);
+        }
+    return wrong + (sim_pixels - drawn);
+}
+
+static void test_random(void) {
+    short v[6];
+    int t, i, big;
+    long wrong;
+
+    srand(11);
+    for (t = 0; t < 3000; t++) {
+        big = (rand() % 4) == 0;
+        for (i = 0; i < 6; i += 2) {
+            if (big) {
+                v[i] = rand() % 30000 - 15000;
+                v[i+1] = rand() % 30000 - 15000;
+            } else {
+                v[i] = rand() % 320 - 40;
+                v[i+1] = rand() % 400 - 40;
+            }
+        }
+        if (t % 5 == 1)
+            v[3] = v[1];    // flat top or bottom
+        if (t % 7 == 2)
+            v[5] = v[3];
+        if (t % 3 == 0)
+            tft_pushClip(rand() % 100, rand() % 100, rand() % 140,
+                         rand() % 220);
+        wrong = check_triangle(v);
+        if (t % 3 == 0)
+            tft_popClip();
+        if (wrong) {
+            printf("triangle (%d,%d) (%d,%d) (%d,%d): %ld pixels wrong\n",
+                   v[0], v[1], v[2], v[3], v[4], v[5], wrong);
+            CHECK(wrong == 0);
+            return;
+        }
+    }
+}
+
+static void test_shared_edges(void) {
+    static const short ring[8][2] = {
+        {20, 10}, {150, 5}, {230, 20}, {235, 160},
+        {200, 310}, {110, 300}, {10, 280}, {5, 140}
+    };
+    struct tft_point p[8];
+    static unsigned short fan[SIM_HEIGHT][SIM_WIDTH];
+    long fan_pixels, x, y, wrong = 0;
+    int i;
+
+    // Two triangles making a 10x10 square: exactly 100 pixels, once each
+    sim_reset(BG);
+    tft_fillTriangle(0, 0, 10, 0, 0, 10, FG);
+    tft_fillTriangle(10, 0, 10, 10, 0, 10, FG);
+    CHECK(sim_pixels == 100);
+    for (y = 0; y < 12; y++)
+        for (x = 0; x < 12; x++)
+            wrong += sim_panel[y][x] != (((x < 10) && (y < 10)) ? FG : BG);
+    CHECK(wrong == 0);
+
+    // A fan around an inner point covers the same pixels as the polygon,
+    // with no pixel drawn twice.
+    sim_reset(BG);
+    for (i = 0; i < 8; i++)
+        tft_fillTriangle(117, 153, ring[i][0], ring[i][1],
+                         ring[(i + 1) % 8][0], ring[(i + 1) % 8][1], FG);
+    fan_pixels = sim_pixels;
+    memcpy(fan, sim_panel, sizeof fan);
+    for (i = 0; i < 8; i++) {
+        p[i].x = ring[i][0];
+        p[i].y = ring[i][1];
+    }
+    sim_reset(BG);
+    tft_fillPolygon(p, 8, FG);
+    CHECK(sim_pixels == fan_pixels);
+    CHECK(memcmp(fan, sim_panel, sizeof fan) == 0);
+    CHECK(sim_errors == 0);
+}
+
+int main(void) {
+    timebase_init();
+    tft_init();
+
+    test_random();
+    test_shared_edges();
+
+    printf("test_triangle: %s\n", sim_failures ? "FAILED" : "ok");
+    return sim_failures != 0;
+}
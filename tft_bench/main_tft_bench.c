@@ -0,0 +1,349 @@
+/*
+ *  @file   main_tft_bench.c
+ *
+ *  @brief  Measures TFT drawing throughput and prints the results over
+ *          UART1 (115200 baud, 8N1).
+ *
+ *          Each test is timed with the core timer, which ticks at SYSCLK/2.
+ *          The "legacy" figures come from copies of the drawing code as it
+ *          was before the corresponding optimization, kept here so the
+ *          two can be compared on the same hardware.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include <stdio.h>
+#include "config.h"
+#include "tft.h"
+#include "uart.h"
+#include "private/tft_spi.h"
+#include "private/glcdfont.h"
+
+#define REPS 10
+#define MAX_DIM 320 // longer side of the display
+
+static unsigned short row_buf[MAX_DIM];
+
+static unsigned int ticks_start;
+
+static void bench_start(void) {
+    ticks_start = ReadCoreTimer();
+}
+
+// Prints throughput for `bytes` bytes sent since bench_start().
+static void bench_report(const char *name, unsigned long bytes) {
+    unsigned int ticks = ReadCoreTimer() - ticks_start;
+    unsigned long long rate = (unsigned long long)bytes * (SYSCLK / 2) / ticks;
+
+    printf("%-24s %8lu us  %8lu bytes/s\r\n", name,
+           (unsigned long)((unsigned long long)ticks * 1000000 / (SYSCLK / 2)),
+           (unsigned long)rate);
+}
+
+// Prints the rate of `n` operations done since bench_start().
+static void bench_rate(const char *name, unsigned long n) {
+    unsigned int ticks = ReadCoreTimer() - ticks_start;
+
+    printf("%-24s %8lu us  %8lu /s\r\n", name,
+           (unsigned long)((unsigned long long)ticks * 1000000 / (SYSCLK / 2)),
+           (unsigned long)((unsigned long long)n * (SYSCLK / 2) / ticks));
+}
+
+// tft_fillRect as it was before 32-bit/ENHBUF streaming: one 16-bit frame
+// at a time, waiting for the bus to go idle after each.
+static void legacy_fillRect(short x, short y, short w, short h,
+                            unsigned short color) {
+    unsigned long n = (unsigned long)w * h;
+
+    tft_setWindow(x, y, x+w-1, y+h-1);
+    tft_windowWritten(n);
+    _dc_high();
+    _cs_low();
+    while (n--) {
+        while (TxBufFullSPI1());
+        WriteSPI1(color);
+        while (SPI1STATbits.SPIBUSY);
+    }
+    _cs_high();
+}
+
+static void bench_fills(void) {
+    unsigned long bytes = (unsigned long)REPS * tft_width() * tft_height() * 2;
+    int i, row;
+
+    bench_start();
+    for (i = 0; i < REPS; i++)
+        legacy_fillRect(0, 0, tft_width(), tft_height(), i & 1 ? ILI9340_BLUE
+                                                               : ILI9340_RED);
+    bench_report("fillScreen (legacy)", bytes);
+
+    bench_start();
+    for (i = 0; i < REPS; i++)
+        tft_fillScreen(i & 1 ? ILI9340_BLUE : ILI9340_RED);
+    bench_report("fillScreen", bytes);
+
+    bench_start();
+    for (i = 0; i < REPS; i++) {
+        tft_fillScreenDMA(i & 1 ? ILI9340_BLUE : ILI9340_RED, NULL);
+        tft_dmaWait();
+    }
+    bench_report("fillScreenDMA", bytes);
+
+    for (i = 0; i < tft_width(); i++)
+        row_buf[i] = tft_Color565(i, 255 - i, 128);
+    bench_start();
+    for (i = 0; i < REPS; i++) {
+        tft_beginWrite();
+        tft_setWindow(0, 0, tft_width() - 1, tft_height() - 1);
+        for (row = 0; row < tft_height(); row++)
+            tft_pushPixels(row_buf, tft_width());
+        tft_endWrite();
+    }
+    bench_report("pushPixels (blit)", bytes);
+}
+
+// tft_drawCircle as it was before span merging: 8 tft_drawPixel calls,
+// each with its own address window, per midpoint step.
+static void legacy_drawCircle(short x0, short y0, short r,
+                              unsigned short color) {
+    short f = 1 - r;
+    short ddF_x = 1;
+    short ddF_y = -2 * r;
+    short x = 0;
+    short y = r;
+
+    tft_beginWrite();
+    tft_drawPixel(x0  , y0+r, color);
+    tft_drawPixel(x0  , y0-r, color);
+    tft_drawPixel(x0+r, y0  , color);
+    tft_drawPixel(x0-r, y0  , color);
+
+    while (x < y) {
+        if (f >= 0) {
+            y--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+        x++;
+        ddF_x += 2;
+        f += ddF_x;
+
+        tft_drawPixel(x0 + x, y0 + y, color);
+        tft_drawPixel(x0 - x, y0 + y, color);
+        tft_drawPixel(x0 + x, y0 - y, color);
+        tft_drawPixel(x0 - x, y0 - y, color);
+        tft_drawPixel(x0 + y, y0 + x, color);
+        tft_drawPixel(x0 - y, y0 + x, color);
+        tft_drawPixel(x0 + y, y0 - x, color);
+        tft_drawPixel(x0 - y, y0 - x, color);
+    }
+    tft_endWrite();
+}
+
+static void bench_circles(void) {
+    static const short radii[] = { 10, 50, 110 };
+    char name[32];
+    unsigned char k;
+    int i;
+
+    for (k = 0; k < sizeof(radii) / sizeof(radii[0]); k++) {
+        tft_fillScreen(ILI9340_BLACK);
+        bench_start();
+        for (i = 0; i < REPS; i++)
+            legacy_drawCircle(tft_width() / 2, tft_height() / 2, radii[k],
+                              i & 1 ? ILI9340_BLUE : ILI9340_RED);
+        sprintf(name, "drawCircle r=%d (legacy)", radii[k]);
+        bench_rate(name, REPS);
+
+        bench_start();
+        for (i = 0; i < REPS; i++)
+            tft_drawCircle(tft_width() / 2, tft_height() / 2, radii[k],
+                           i & 1 ? ILI9340_BLUE : ILI9340_RED);
+        sprintf(name, "drawCircle r=%d", radii[k]);
+        bench_rate(name, REPS);
+    }
+}
+
+// tft_drawChar as it was before single-window glyphs: a pixel or a
+// size x size rectangle, each with its own window, per font cell.
+static void legacy_drawChar(short x, short y, unsigned char c,
+                            unsigned short color, unsigned short bg,
+                            unsigned char size) {
+    char i, j;
+    unsigned char line;
+
+    tft_beginWrite();
+    for (i = 0; i < 6; i++ ) {
+        line = (i == 5) ? 0 : font[c * 5 + i];
+        for (j = 0; j < 8; j++) {
+            if (line & 0x1) {
+                if (size == 1)
+                    tft_drawPixel(x+i, y+j, color);
+                else
+                    tft_fillRect(x+(i*size), y+(j*size), size, size, color);
+            } else if (bg != color) {
+                if (size == 1)
+                    tft_drawPixel(x+i, y+j, bg);
+                else
+                    tft_fillRect(x+i*size, y+j*size, size, size, bg);
+            }
+            line >>= 1;
+        }
+    }
+    tft_endWrite();
+}
+
+static void bench_text(void) {
+    static const char digits[] = "0123456789.-:";
+    const unsigned long glyphs = REPS * (sizeof(digits) - 1);
+    unsigned char size, k;
+    char name[32];
+    int i;
+
+    for (size = 1; size <= 3; size += 2) {
+        bench_start();
+        for (i = 0; i < REPS; i++) {
+            for (k = 0; digits[k]; k++)
+                legacy_drawChar(k * 6 * size, 0, digits[k], ILI9340_WHITE,
+                                ILI9340_BLACK, size);
+        }
+        sprintf(name, "drawChar x%d (legacy)", size);
+        bench_rate(name, glyphs);
+
+        bench_start();
+        for (i = 0; i < REPS; i++) {
+            for (k = 0; digits[k]; k++)
+                tft_drawChar(k * 6 * size, 0, digits[k], ILI9340_WHITE,
+                             ILI9340_BLACK, size);
+        }
+        sprintf(name, "drawChar x%d", size);
+        bench_rate(name, glyphs);
+
+        bench_start();
+        for (i = 0; i < REPS; i++)
+            tft_drawText(0, 0, digits, ILI9340_WHITE, ILI9340_BLACK, size);
+        sprintf(name, "drawText x%d", size);
+        bench_rate(name, glyphs);
+    }
+}
+
+// tft_fillTriangle as it was before exact edge stepping: two divisions
+// per scanline, and both end pixels of every span drawn.
+static void legacy_fillTriangle(short x0, short y0, short x1, short y1,
+                                short x2, short y2, unsigned short color) {
+    short a, b, y, last, t;
+
+    if (y0 > y1) { t = y0; y0 = y1; y1 = t; t = x0; x0 = x1; x1 = t; }
+    if (y1 > y2) { t = y2; y2 = y1; y1 = t; t = x2; x2 = x1; x1 = t; }
+    if (y0 > y1) { t = y0; y0 = y1; y1 = t; t = x0; x0 = x1; x1 = t; }
+
+    if (y0 == y2) {
+        a = b = x0;
+        if (x1 < a)      a = x1;
+        else if (x1 > b) b = x1;
+        if (x2 < a)      a = x2;
+        else if (x2 > b) b = x2;
+        tft_drawFastHLine(a, y0, b-a+1, color);
+        return;
+    }
+
+    short dx01 = x1 - x0, dy01 = y1 - y0, dx02 = x2 - x0, dy02 = y2 - y0,
+          dx12 = x2 - x1, dy12 = y2 - y1, sa = 0, sb = 0;
+
+    last = (y1 == y2) ? y1 : y1 - 1;
+    for (y = y0; y <= last; y++) {
+        a = x0 + sa / dy01;
+        b = x0 + sb / dy02;
+        sa += dx01;
+        sb += dx02;
+        if (a > b) { t = a; a = b; b = t; }
+        tft_drawFastHLine(a, y, b-a+1, color);
+    }
+    sa = dx12 * (y - y1);
+    sb = dx02 * (y - y0);
+    for (; y <= y2; y++) {
+        a = x1 + sa / dy12;
+        b = x0 + sb / dy02;
+        sa += dx12;
+        sb += dx02;
+        if (a > b) { t = a; a = b; b = t; }
+        tft_drawFastHLine(a, y, b-a+1, color);
+    }
+}
+
+static void bench_triangles(void) {
+    static const short sizes[] = { 12, 60, 200 };
+    char name[32];
+    unsigned char k, m;
+    unsigned long seed;
+    short v[6], n;
+    int i, j;
+
+    for (k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        n = (sizes[k] < 100) ? 200 : 20;
+        for (j = 0; j < 2; j++) {
+            tft_fillScreen(ILI9340_BLACK);
+            seed = 12345;   // the same triangles for both versions
+            bench_start();
+            for (i = 0; i < n; i++) {
+                for (m = 0; m < 6; m++) {
+                    seed = seed * 1103515245 + 12345;
+                    v[m] = (seed >> 16) % sizes[k];
+                }
+                if (j == 0)
+                    legacy_fillTriangle(v[0], v[1], v[2], v[3], v[4], v[5],
+                                        i & 1 ? ILI9340_BLUE : ILI9340_RED);
+                else
+                    tft_fillTriangle(v[0], v[1], v[2], v[3], v[4], v[5],
+                                     i & 1 ? ILI9340_BLUE : ILI9340_RED);
+            }
+            sprintf(name, "fillTriangle %d%s", sizes[k],
+                    j == 0 ? " (legacy)" : "");
+            bench_rate(name, n);
+        }
+    }
+}
+
+static void bench_chart(void) {
+    static struct tft_chart chart;
+    short v[2], t;
+    int i;
+
+    tft_chartInit(&chart, 0, 0, tft_width(), tft_height(), -128, 127,
+                  ILI9340_BLACK);
+    tft_chartGrid(&chart, 40, 30, 0x2104);
+    tft_chartAddTrace(&chart, ILI9340_YELLOW);
+    tft_chartAddTrace(&chart, ILI9340_CYAN);
+    tft_chartClear(&chart);
+
+    // a triangle wave and a square wave, each a few cycles per sweep
+    bench_start();
+    for (i = 0; i < 2000; i++) {
+        t = i & 63;
+        v[0] = (t < 32) ? t * 8 - 128 : 383 - t * 8;
+        v[1] = (i & 32) ? 100 : -100;
+        tft_chartAdd(&chart, v);
+    }
+    bench_rate("chartAdd, 2 traces", 2000);
+}
+
+int main(void) {
+    SYSTEMConfig(SYSCLK, SYS_CFG_WAIT_STATES | SYS_CFG_PCACHE);
+    wclib_init(SYSCLK, PBCLK);
+    INTEnableSystemMultiVectoredInt();  // DMA completion uses an interrupt
+
+    uart_init();
+    tft_init();
+    tft_setRotation(1);
+
+    printf("\r\nTFT benchmark, SPI line rate %lu bytes/s\r\n",
+           (unsigned long)(PBCLK / 2 / 8));
+    bench_fills();
+    bench_circles();
+    bench_text();
+    bench_triangles();
+    bench_chart();
+
+    while (1) { ; }
+    return 0;
+}
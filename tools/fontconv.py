@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""Convert a TTF/OTF or BDF font to a C source file for tft_font.
+
+Writes a `const struct tft_font` (see wcpic32lib/tft_font.h) with 2 or 4 bits
+per pixel anti-aliased glyph bitmaps, run-length encoded.
+
+    fontconv.py DejaVuSans.ttf --size 12 --bpp 4 --name dejavu12 -o dejavu12.c
+    fontconv.py ter-u16n.bdf --bpp 2 --name terminus16 -o terminus16.c
+
+TrueType input needs Pillow (pip install pillow). BDF fonts are 1 bit per
+pixel, so their glyphs only use coverage values 0 and the maximum.
+"""
+
+import argparse
+import sys
+
+MAX_WIDTH = 64      # TFT_FONT_MAX_WIDTH
+
+
+class Glyph:
+    def __init__(self, advance, x_off=0, y_off=0, rows=None):
+        self.advance = advance
+        self.x_off = x_off      # bitmap position relative to cell top left
+        self.y_off = y_off
+        self.rows = rows or []  # coverage rows, 0..255
+
+
+def load_ttf(path, size, first, last):
+    try:
+        from PIL import Image, ImageDraw, ImageFont
+    except ImportError:
+        sys.exit("fontconv: TrueType input needs Pillow (pip install pillow)")
+    font = ImageFont.truetype(path, size)
+    ascent, descent = font.getmetrics()
+    glyphs = {}
+    for code in range(first, last + 1):
+        ch = chr(code)
+        advance = int(round(font.getlength(ch)))
+        left, top, right, bottom = font.getbbox(ch, anchor="ls")
+        if right <= left or bottom <= top:
+            glyphs[code] = Glyph(advance)
+            continue
+        img = Image.new("L", (right - left, bottom - top), 0)
+        ImageDraw.Draw(img).text((-left, -top), ch, fill=255, font=font,
+                                 anchor="ls")
+        w, h = img.size
+        px = img.load()
+        rows = [[px[i, j] for i in range(w)] for j in range(h)]
+        glyphs[code] = Glyph(advance, left, ascent + top, rows)
+    return glyphs, ascent + descent, ascent
+
+
+def load_bdf(path, first, last):
+    glyphs = {}
+    ascent = descent = 0
+    code = None
+    with open(path, encoding="latin-1") as f:
+        lines = iter(f.read().splitlines())
+    for line in lines:
+        words = line.split()
+        if not words:
+            continue
+        key = words[0]
+        if key == "FONT_ASCENT":
+            ascent = int(words[1])
+        elif key == "FONT_DESCENT":
+            descent = int(words[1])
+        elif key == "ENCODING":
+            code = int(words[1])
+        elif key == "DWIDTH":
+            advance = int(words[1])
+        elif key == "BBX":
+            w, h, bx, by = (int(v) for v in words[1:5])
+        elif key == "BITMAP":
+            rows = []
+            for _ in range(h):
+                bits = int(next(lines), 16)
+                nbits = ((w + 7) // 8) * 8
+                rows.append([255 if bits & (1 << (nbits - 1 - i)) else 0
+                             for i in range(w)])
+            if code is not None and first <= code <= last:
+                glyphs[code] = Glyph(advance, bx, ascent - (by + h), rows)
+            code = None
+    return glyphs, ascent + descent, ascent
+
+
+def fit(g, height):
+    """Trim blank edges and clip the bitmap to the character cell."""
+    rows = g.rows
+    # rows above and below the cell
+    if g.y_off < 0:
+        rows = rows[-g.y_off:]
+        g.y_off = 0
+    rows = rows[:max(0, height - g.y_off)]
+    while rows and not any(rows[0]):
+        rows = rows[1:]
+        g.y_off += 1
+    while rows and not any(rows[-1]):
+        rows = rows[:-1]
+    if not rows:
+        g.rows, g.x_off, g.y_off = [], 0, 0
+        return
+    # blank columns
+    w = len(rows[0])
+    left = min(next(i for i, v in enumerate(r) if v) for r in rows if any(r))
+    right = max(w - next(i for i, v in enumerate(reversed(r)) if v)
+                for r in rows if any(r))
+    rows = [r[left:right] for r in rows]
+    g.x_off += left
+    # overhang on the left: shift the glyph right and widen the cell
+    if g.x_off < 0:
+        g.advance -= g.x_off
+        g.x_off = 0
+    # overhang on the right: widen the cell
+    g.advance = max(g.advance, g.x_off + len(rows[0]))
+    g.rows = rows
+
+
+def encode(rows, bpp):
+    levels = 1 << bpp
+    maxrun = 1 << (8 - bpp)
+    values = [(v * (levels - 1) + 127) // 255 for r in rows for v in r]
+    out = []
+    i = 0
+    while i < len(values):
+        v = values[i]
+        n = 1
+        while i + n < len(values) and values[i + n] == v and n < maxrun:
+            n += 1
+        out.append(((n - 1) << bpp) | v)
+        i += n
+    return out
+
+
+def decode(data, bpp, count):
+    values = []
+    for b in data:
+        values += [b & ((1 << bpp) - 1)] * ((b >> bpp) + 1)
+    assert len(values) == count
+    return values
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("font", help="TTF, OTF or BDF file")
+    ap.add_argument("--size", type=int, default=12,
+                    help="pixel size for TrueType fonts (default 12)")
+    ap.add_argument("--bpp", type=int, choices=(2, 4), default=4)
+    ap.add_argument("--name", required=True, help="C identifier for the font")
+    ap.add_argument("--first", type=int, default=32)
+    ap.add_argument("--last", type=int, default=126)
+    ap.add_argument("-o", "--output", help="output file (default stdout)")
+    args = ap.parse_args()
+
+    if args.font.lower().endswith(".bdf"):
+        glyphs, height, ascent = load_bdf(args.font, args.first, args.last)
+    else:
+        glyphs, height, ascent = load_ttf(args.font, args.size, args.first,
+                                          args.last)
+    if height > 255:
+        sys.exit("fontconv: font is too tall")
+
+    entries = []
+    data = []
+    for code in range(args.first, args.last + 1):
+        g = glyphs.get(code, Glyph(0))
+        fit(g, height)
+        if g.advance > MAX_WIDTH:
+            sys.exit("fontconv: character %d is %d pixels wide (max %d)"
+                     % (code, g.advance, MAX_WIDTH))
+        enc = encode(g.rows, args.bpp)
+        w = len(g.rows[0]) if g.rows else 0
+        decode(enc, args.bpp, w * len(g.rows))
+        entries.append((len(data), w, len(g.rows), g.x_off, g.y_off,
+                        g.advance, code))
+        data += enc
+    if len(data) > 65535:
+        sys.exit("fontconv: glyph data is too large")
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    name = args.name
+    out.write("// Generated by fontconv.py from %s\n"
+              % args.font.replace("\\", "/").split("/")[-1])
+    out.write("// %d bpp, height %d, ascent %d, %d bytes of glyph data\n\n"
+              % (args.bpp, height, ascent, len(data)))
+    out.write('#include "tft_font.h"\n\n')
+    out.write("static const unsigned char %s_data[] = {\n" % name)
+    for i in range(0, len(data), 12):
+        out.write("    " + ", ".join("0x%02X" % b for b in data[i:i + 12])
+                  + ",\n")
+    if not data:
+        out.write("    0\n")
+    out.write("};\n\n")
+    out.write("static const struct tft_glyph %s_glyphs[] = {\n" % name)
+    for e in entries:
+        c = chr(e[6])
+        label = "'%s'" % c if c.isprintable() and c not in "\\'" else str(e[6])
+        out.write("    { %5d, %2d, %2d, %2d, %2d, %2d },   // %s\n"
+                  % (e[:6] + (label,)))
+    out.write("};\n\n")
+    out.write("const struct tft_font %s = {\n" % name)
+    out.write("    %d, %d, %d, %d, %d, %s_glyphs, %s_data\n"
+              % (args.bpp, args.first, args.last, height, ascent, name, name))
+    out.write("};\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""Convert an image to a compressed C array for tft_drawImage().
+
+Writes a `const struct tft_image` (see wcpic32lib/tft_image.h) holding the
+image as lossless 5-6-5 RGB, compressed in the format tft_image.c decodes.
+
+    imgconv.py splash.png --name splash -o splash.c
+
+Binary PPM (P6) files are read directly; other formats (PNG, BMP, ...)
+need Pillow (pip install pillow). Colors are rounded to 5-6-5 first.
+"""
+
+import argparse
+import sys
+
+MAX_WIDTH = 320     # TFT_IMAGE_MAX_WIDTH
+
+OP_INDEX = 0x00
+OP_DIFF = 0x40
+OP_LUMA = 0x80
+OP_RUN = 0xC0
+OP_RGB = 0xFE
+MAX_RUN = 62
+
+
+def read_ppm(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    fields = []
+    pos = 0
+    while len(fields) < 4:
+        while data[pos:pos + 1].isspace():
+            pos += 1
+        if data[pos:pos + 1] == b"#":
+            while data[pos:pos + 1] not in (b"\n", b""):
+                pos += 1
+            continue
+        start = pos
+        while not data[pos:pos + 1].isspace():
+            pos += 1
+        fields.append(data[start:pos])
+    if fields[0] != b"P6" or int(fields[3]) != 255:
+        sys.exit("imgconv: only 8-bit binary PPM (P6) is read without Pillow")
+    w, h = int(fields[1]), int(fields[2])
+    pix = data[pos + 1:pos + 1 + 3 * w * h]
+    return w, h, [tuple(pix[i:i + 3]) for i in range(0, len(pix), 3)]
+
+
+def read_image(path):
+    if path.lower().endswith((".ppm", ".pnm")):
+        return read_ppm(path)
+    try:
+        from PIL import Image
+    except ImportError:
+        sys.exit("imgconv: %s needs Pillow (pip install pillow), "
+                 "or convert it to PPM first" % path)
+    img = Image.open(path).convert("RGB")
+    return img.width, img.height, list(img.getdata())
+
+
+def to565(rgb):
+    r, g, b = rgb
+    return ((r * 31 + 127) // 255, (g * 63 + 127) // 255,
+            (b * 31 + 127) // 255)
+
+
+def wrap(v, bits):
+    """v as a signed value of the given width."""
+    v &= (1 << bits) - 1
+    return v - (1 << bits) if v >= 1 << (bits - 1) else v
+
+
+def encode(pixels):
+    out = bytearray()
+    recent = [(0, 0, 0)] * 64
+    prev = (0, 0, 0)
+    run = 0
+    for i, px in enumerate(pixels):
+        if px == prev:
+            run += 1
+            if run == MAX_RUN or i == len(pixels) - 1:
+                out.append(OP_RUN | (run - 1))
+                run = 0
+            continue
+        if run:
+            out.append(OP_RUN | (run - 1))
+            run = 0
+        r, g, b = px
+        h = (r * 3 + g * 5 + b * 7) & 63
+        if recent[h] == px:
+            out.append(OP_INDEX | h)
+        else:
+            recent[h] = px
+            dr = wrap(r - prev[0], 5)
+            dg = wrap(g - prev[1], 6)
+            db = wrap(b - prev[2], 5)
+            half = dg >> 1      # rounded down
+            rd = wrap(dr - half, 5)
+            bd = wrap(db - half, 5)
+            if -2 <= dr <= 1 and -2 <= dg <= 1 and -2 <= db <= 1:
+                out.append(OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2))
+            elif -8 <= rd <= 7 and -8 <= bd <= 7:
+                out.append(OP_LUMA | (dg + 32))
+                out.append((rd + 8) << 4 | (bd + 8))
+            else:
+                c = r << 11 | g << 5 | b
+                out += bytes((OP_RGB, c >> 8, c & 0xFF))
+        prev = px
+    return out
+
+
+def decode(data, n):
+    """Reference decoder, used to check the output."""
+    pixels = []
+    recent = [(0, 0, 0)] * 64
+    r = g = b = 0
+    pos = 0
+    while len(pixels) < n:
+        op = data[pos]
+        pos += 1
+        if op == OP_RGB:
+            c = data[pos] << 8 | data[pos + 1]
+            pos += 2
+            r, g, b = c >> 11, (c >> 5) & 0x3F, c & 0x1F
+        elif op & 0xC0 == OP_RUN:
+            pixels += [(r, g, b)] * ((op & 0x3F) + 1)
+            continue
+        elif op & 0xC0 == OP_INDEX:
+            r, g, b = recent[op]
+        elif op & 0xC0 == OP_DIFF:
+            r = (r + ((op >> 4) & 3) - 2) & 0x1F
+            g = (g + ((op >> 2) & 3) - 2) & 0x3F
+            b = (b + (op & 3) - 2) & 0x1F
+        else:
+            b2 = data[pos]
+            pos += 1
+            dg = (op & 0x3F) - 32
+            half = dg >> 1
+            g = (g + dg) & 0x3F
+            r = (r + half + (b2 >> 4) - 8) & 0x1F
+            b = (b + half + (b2 & 0xF) - 8) & 0x1F
+        recent[(r * 3 + g * 5 + b * 7) & 63] = (r, g, b)
+        pixels.append((r, g, b))
+    return pixels
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("image", help="PPM, or any format Pillow reads")
+    ap.add_argument("--name", required=True, help="C identifier for the image")
+    ap.add_argument("-o", "--output", help="output file (default stdout)")
+    args = ap.parse_args()
+
+    w, h, rgb = read_image(args.image)
+    if w > MAX_WIDTH or w < 1 or h < 1 or h > 32767:
+        sys.exit("imgconv: image is %dx%d (at most %d wide)"
+                 % (w, h, MAX_WIDTH))
+    pixels = [to565(p) for p in rgb]
+    data = encode(pixels)
+    assert decode(data, len(pixels)) == pixels
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    name = args.name
+    out.write("// Generated by imgconv.py from %s\n"
+              % args.image.replace("\\", "/").split("/")[-1])
+    out.write("// %dx%d, %d bytes (%d%% of raw 5-6-5)\n\n"
+              % (w, h, len(data), 100 * len(data) // (2 * w * h)))
+    out.write('#include "tft_image.h"\n\n')
+    out.write("static const unsigned char %s_data[] = {\n" % name)
+    for i in range(0, len(data), 12):
+        out.write("    " + ", ".join("0x%02X" % v for v in data[i:i + 12])
+                  + ",\n")
+    out.write("};\n\n")
+    out.write("const struct tft_image %s = { %d, %d, %s_data };\n"
+              % (name, w, h, name))
+
+
+if __name__ == "__main__":
+    main()
@@ -36,6 +36,7 @@
 #include <stdio.h>
 #include "private/common.h"
 #include "amp.h"
+#include "timebase.h"
 #include "uart.h"
 
 #define DEBUG   // If DEGUG is defined, UART1 will be configured and used for
@@ -43,6 +44,10 @@
 
 #define I2C_CLOCK_FREQ 400000  // standard 10 KHz I2C clock speed
 
+// Pause before each stop_transfer(): long enough for the last byte and its
+// acknowledge (9 bit times, 22.5 us at 400 kHz) to finish.
+#define STOP_DELAY_US  25
+
 // utility functions
 static void write8(uint8_t address, uint8_t data);
 static uint8_t read8(uint8_t address);
@@ -50,7 +55,6 @@ static bool start_transfer(bool restart);
 static void stop_transfer();
 static bool transmit_byte(uint8_t data);
 static void debug_log(const char *string);
-static void delay();
 
 /**
  *  Configures and enables an I2C module for communicating with the TPA2016.
@@ -324,7 +328,7 @@ static uint8_t read8(uint8_t address) {
 //    debug_log("read8: get byte\n");
     data = I2CGetByte(TPA2016_I2C_BUS);
 
-    delay(); // kludge -- the following stop_transfer() hangs otherwise
+    delay_us(STOP_DELAY_US); // kludge -- the following stop_transfer() hangs otherwise
     stop_transfer();
 
     return data;
@@ -365,7 +369,7 @@ static void write8(uint8_t address, uint8_t data) {
         while(1) { ; }
     }
 
-    delay(); // kludge -- the following stop_transfer() hangs otherwise
+    delay_us(STOP_DELAY_US); // kludge -- the following stop_transfer() hangs otherwise
     stop_transfer();
 }
 
@@ -466,9 +470,3 @@ static void debug_log(const char *string) {
     uart_write(string);
 #endif
 }
-
-static void delay() {
-    volatile int j;
-    for (j = 0; j < 100; j++) {
-    }
-}
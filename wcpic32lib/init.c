@@ -5,6 +5,7 @@
  */
 
 #include "private/common.h"
+#include "timebase.h"
 
 // Globals exported to the WC PIC32 libraries
 unsigned _sysclk, _pbclk;
@@ -13,6 +14,7 @@ unsigned _sysclk, _pbclk;
  *  Tells wcpic32lib our system clock and peripheral bus clock rates.
  *
  *  This function must be called before using any other wcpic32lib functions.
+ *  It also starts the timebase (timebase.h).
  *
  *  Example:
  *
@@ -21,4 +23,5 @@ unsigned _sysclk, _pbclk;
 void wclib_init(unsigned sysclk, unsigned pbclk) {
     _sysclk = sysclk;
     _pbclk = pbclk;
+    timebase_init();
 }
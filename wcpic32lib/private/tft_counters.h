@@ -0,0 +1,94 @@
+#ifndef TFT_COUNTERS_H
+#define TFT_COUNTERS_H
+
+/*
+ *  @file   tft_counters.h
+ *
+ *  @brief  Per-primitive performance counters for the TFT driver, compiled
+ *          in only when the library is built with TFT_STATS defined (see
+ *          tft_stats.h). Not part of the public API.
+ *
+ *          Each public drawing function starts with TFT_STAT_PRIM(); work
+ *          done until it returns, including in the functions it calls, is
+ *          charged to that primitive.
+ */
+
+#include "common.h"
+
+#ifdef TFT_STATS
+
+enum {
+    TFT_STAT_OTHER,
+    TFT_STAT_PIXEL,
+    TFT_STAT_HLINE,
+    TFT_STAT_VLINE,
+    TFT_STAT_FILLRECT,
+    TFT_STAT_PUSH,
+    TFT_STAT_LINE,
+    TFT_STAT_RECT,
+    TFT_STAT_CIRCLE,
+    TFT_STAT_FILLCIRCLE,
+    TFT_STAT_ROUNDRECT,
+    TFT_STAT_FILLROUNDRECT,
+    TFT_STAT_TRIANGLE,
+    TFT_STAT_FILLTRIANGLE,
+    TFT_STAT_BITMAP,
+    TFT_STAT_CHAR,
+    TFT_STAT_TEXT,
+    TFT_STAT_POLYGON,
+    TFT_STAT_GRADIENT,
+    TFT_STAT_CHART,
+    TFT_STAT_COUNT
+};
+
+struct tft_counters {
+    unsigned long calls;    // outermost calls
+    unsigned long pixels;   // pixels written
+    unsigned long words;    // SPI frames queued (8, 16 or 32 bits)
+    unsigned long windows;  // CASET/PASET address window setups
+    unsigned long modes;    // SPI frame size switches
+    unsigned long wait;     // core timer ticks spent waiting on SPI1
+};
+
+extern struct tft_counters _tft_counters[TFT_STAT_COUNT];
+extern unsigned char _tft_stat_prim, _tft_stat_depth;
+
+static inline unsigned char _tft_stat_enter(unsigned char prim) {
+    if (_tft_stat_depth++ == 0) {
+        _tft_stat_prim = prim;
+        _tft_counters[prim].calls++;
+    }
+    return prim;
+}
+
+static inline void _tft_stat_leave(unsigned char *prim) {
+    (void)prim;
+    if (--_tft_stat_depth == 0)
+        _tft_stat_prim = TFT_STAT_OTHER;
+}
+
+// Charges the rest of the enclosing function to primitive `prim` (e.g.
+// PIXEL), unless it was called from within another primitive. Must come
+// last among the declarations.
+#define TFT_STAT_PRIM(prim) \
+    unsigned char _tft_stat __attribute__((cleanup(_tft_stat_leave))) = \
+        _tft_stat_enter(TFT_STAT_##prim)
+
+#define TFT_STAT_ADD(field, n)  (_tft_counters[_tft_stat_prim].field += (n))
+
+// Busy-waits while cond holds, counting the time spent.
+#define TFT_WAIT(cond) do {                                 \
+        unsigned _tft_t0 = ReadCoreTimer();                 \
+        while (cond) { ; }                                  \
+        TFT_STAT_ADD(wait, ReadCoreTimer() - _tft_t0);      \
+    } while (0)
+
+#else
+
+#define TFT_STAT_PRIM(prim)
+#define TFT_STAT_ADD(field, n)  ((void)0)
+#define TFT_WAIT(cond)          do { while (cond) { ; } } while (0)
+
+#endif // TFT_STATS
+
+#endif // TFT_COUNTERS_H
@@ -0,0 +1,53 @@
+#ifndef TFT_EDGE_H
+#define TFT_EDGE_H
+
+/*
+ *  @file   tft_edge.h
+ *
+ *  @brief  Exact, division-free edge stepping for the scanline fills in
+ *          tft_gfx.c and tft_poly.c. Not part of the public API.
+ *
+ *          An edge covers the pixels whose centers are at or right of
+ *          it, so spans run from the left edge's x up to, but not
+ *          including, the right edge's x (the top-left rule).
+ */
+
+// An edge being stepped down the scanlines: it crosses the current one at
+// x - r / dy (0 <= r < dy), so x is the first pixel at or right of the
+// crossing, and it moves qs + rs / dy (0 <= rs < dy) pixels per scanline.
+struct tft_edge {
+    long x, r, dy, qs, rs;
+};
+
+// Starts the edge from (xa, ya) down to (xb, yb) (ya < yb) on scanline y.
+static inline void tft_edgeStart(struct tft_edge *e, short xa, short ya,
+                                 short xb, short yb, short y) {
+    long long num, x;
+    long dx = xb - xa;
+
+    e->dy = yb - ya;
+    e->qs = dx / e->dy;
+    e->rs = dx % e->dy;
+    if (e->rs < 0) {
+        e->qs--;
+        e->rs += e->dy;
+    }
+    num = (long long)xa * e->dy + (long long)(y - ya) * dx;
+    x = num / e->dy;
+    if (x * e->dy < num)    // round up (division truncates toward 0)
+        x++;
+    e->x = x;
+    e->r = x * e->dy - num;
+}
+
+// Moves the edge down one scanline.
+static inline void tft_edgeStep(struct tft_edge *e) {
+    e->x += e->qs;
+    e->r -= e->rs;
+    if (e->r < 0) {
+        e->r += e->dy;
+        e->x++;
+    }
+}
+
+#endif // TFT_EDGE_H
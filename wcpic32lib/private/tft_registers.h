@@ -67,7 +67,11 @@
 #define ILI9340_RAMRD   0x2E
 
 #define ILI9340_PTLAR   0x30
+#define ILI9340_VSCRDEF 0x33
+#define ILI9340_TEOFF   0x34
+#define ILI9340_TEON    0x35
 #define ILI9340_MADCTL  0x36
+#define ILI9340_VSCRSADD 0x37
 
 #define ILI9340_MADCTL_MY  0x80
 #define ILI9340_MADCTL_MX  0x40
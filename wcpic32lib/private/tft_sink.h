@@ -0,0 +1,34 @@
+#ifndef TFT_SINK_H
+#define TFT_SINK_H
+
+/*
+ *  @file   tft_sink.h
+ *
+ *  @brief  Hook for redirecting the TFT driver's pixel output somewhere
+ *          other than the display (see tft_fb.c). Not part of the public
+ *          API.
+ *
+ *          While _tft_sink is not NULL, tft_drawPixel(), tft_setWindow(),
+ *          tft_pushPixels() and tft_pushColorN() hand their arguments to
+ *          it instead of talking to the display. Every other drawing
+ *          function is built on those four, so all of them follow.
+ *          tft_readRect() reads back through it too.
+ */
+
+struct tft_sink {
+    void (*drawPixel)(short x, short y, unsigned short color);
+    void (*setWindow)(short x0, short y0, short x1, short y1);
+    void (*pushPixels)(const unsigned short *buf, unsigned long n);
+    void (*pushColorN)(unsigned short color, unsigned long n);
+    // (x, y, w, h) is in screen coordinates and entirely on the screen
+    void (*readRect)(short x, short y, short w, short h, unsigned short *buf);
+};
+
+extern const struct tft_sink *_tft_sink;
+
+// Like tft_setWindow(), but in screen coordinates and ignoring the clip
+// rectangle and origin, for sending a framebuffer's pixels to the display
+// while drawing is still redirected to it. Call with _tft_sink NULL.
+void tft_screenWindow(short x0, short y0, short x1, short y1);
+
+#endif // TFT_SINK_H
@@ -0,0 +1,59 @@
+#ifndef TFT_SPI_H
+#define TFT_SPI_H
+
+/*
+ *  @file   tft_spi.h
+ *
+ *  @brief  Pin assignments and low-level SPI1 helpers shared by the TFT
+ *          driver modules. Not part of the public API.
+ */
+
+#include <xc.h>
+#include "common.h"
+#include "tft_counters.h"
+
+#define _dc         LATBbits.LATB9
+#define TRIS_dc     TRISBbits.TRISB9
+#define _dc_high()  {LATBSET = 1 << 9;}
+#define _dc_low()   {LATBCLR = 1 << 9;}
+
+#define _cs         LATBbits.LATB8
+#define TRIS_cs     TRISBbits.TRISB8
+#define _cs_high()  {LATBSET = 1 << 8;}
+#define _cs_low()   {LATBCLR = 1 << 8;}
+
+#define _rst        LATBbits.LATB2
+#define TRIS_rst    TRISBbits.TRISB2
+#define _rst_high() {LATBSET = 1 << 2;}
+#define _rst_low()  {LATBCLR = 1 << 2;}
+
+// SPI1 frame size. Only change it while SPI1 is idle (SPIBUSY clear).
+static inline void Mode16(void){  // configure SPI1 for 16-bit mode
+    SPI1CONCLR = 0x800;
+    SPI1CONSET = 0x400;
+    TFT_STAT_ADD(modes, 1);
+}
+
+static inline void Mode8(void){  // configure SPI1 for 8-bit mode
+    SPI1CONCLR = 0xC00;
+    TFT_STAT_ADD(modes, 1);
+}
+
+static inline void Mode32(void){  // configure SPI1 for 32-bit mode
+    SPI1CONCLR = 0x400;
+    SPI1CONSET = 0x800;
+    TFT_STAT_ADD(modes, 1);
+}
+
+// Nonzero while a DMA transfer (see tft_dma.c) owns SPI1 and holds CS low.
+extern volatile unsigned char _tft_dma_busy;
+
+// Blocks until any DMA transfer in progress has released SPI1.
+static inline void tft_waitDMA(void) {
+    while (_tft_dma_busy) { ; }
+}
+
+void tft_windowWritten(unsigned long n);
+void tft_command(unsigned char c, const unsigned char *args, unsigned char n);
+
+#endif // TFT_SPI_H
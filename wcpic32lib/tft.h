@@ -14,5 +14,16 @@
 
 #include "tft_gfx.h"
 #include "tft_master.h"
+#include "tft_dma.h"
+#include "tft_console.h"
+#include "tft_band.h"
+#include "tft_fb.h"
+#include "tft_sync.h"
+#include "tft_stats.h"
+#include "tft_font.h"
+#include "tft_poly.h"
+#include "tft_gradient.h"
+#include "tft_image.h"
+#include "tft_chart.h"
 
 #endif
@@ -0,0 +1,401 @@
+/*
+ *  @file   tft_band.c
+ *
+ *  @brief  A banded renderer for the TFT: primitives are recorded for a
+ *          frame, composited band by band in a RAM line buffer, and each
+ *          band is streamed to the display once.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include <stdlib.h>
+#include "tft_band.h"
+#include "tft_gfx.h"
+#include "tft_master.h"
+#include "private/glcdfont.h"
+
+#ifndef TFT_BAND_PIXELS
+#define TFT_BAND_PIXELS     (320 * 16)
+#endif
+
+#ifndef TFT_BAND_MAX_PRIMS
+#define TFT_BAND_MAX_PRIMS  64
+#endif
+
+enum { PRIM_RECT, PRIM_LINE, PRIM_CIRCLE, PRIM_FILL_CIRCLE, PRIM_TEXT };
+
+struct prim {
+    unsigned char type;
+    unsigned char size;         // text size
+    short x0, y0, x1, y1;       // see the tft_band... functions
+    short top, bottom;          // rows touched, for skipping bands
+    unsigned short color, bg;
+    const char *str;
+};
+
+static unsigned short band_buf[TFT_BAND_PIXELS];
+static struct prim prims[TFT_BAND_MAX_PRIMS];
+static unsigned char nprims;
+
+static short reg_x, reg_y, reg_w, reg_h;   // region being rendered
+static unsigned short reg_bg;
+
+// Rows of the region currently held in band_buf
+static short band_y0, band_y1;
+
+/*
+ *  Rasterizing into the band buffer. Everything is in screen coordinates
+ *  and silently clipped to the region and the current band.
+ */
+
+static void band_hspan(short x0, short x1, short y, unsigned short color) {
+    unsigned short *p;
+
+    if ((y < band_y0) || (y > band_y1))
+        return;
+    if (x0 < reg_x)
+        x0 = reg_x;
+    if (x1 > reg_x + reg_w - 1)
+        x1 = reg_x + reg_w - 1;
+    p = band_buf + (y - band_y0) * reg_w + (x0 - reg_x);
+    for (; x0 <= x1; x0++)
+        *p++ = color;
+}
+
+static inline void band_plot(short x, short y, unsigned short color) {
+    band_hspan(x, x, y, color);
+}
+
+static void band_vspan(short x, short y0, short y1, unsigned short color) {
+    if (y0 < band_y0)
+        y0 = band_y0;
+    if (y1 > band_y1)
+        y1 = band_y1;
+    for (; y0 <= y1; y0++)
+        band_plot(x, y0, color);
+}
+
+// Same algorithm as tft_drawLine(), so the result is pixel-identical.
+static void band_line(short x0, short y0, short x1, short y1,
+                      unsigned short color) {
+    short steep = abs(y1 - y0) > abs(x1 - x0);
+    short dx, dy, err, ystep, t;
+
+    if (steep) {
+        t = x0; x0 = y0; y0 = t;
+        t = x1; x1 = y1; y1 = t;
+    }
+    if (x0 > x1) {
+        t = x0; x0 = x1; x1 = t;
+        t = y0; y0 = y1; y1 = t;
+    }
+    dx = x1 - x0;
+    dy = abs(y1 - y0);
+    err = dx / 2;
+    ystep = (y0 < y1) ? 1 : -1;
+
+    for (; x0 <= x1; x0++) {
+        if (steep)
+            band_plot(y0, x0, color);
+        else
+            band_plot(x0, y0, color);
+        err -= dy;
+        if (err < 0) {
+            y0 += ystep;
+            err += dx;
+        }
+    }
+}
+
+// Same midpoint algorithm as tft_drawCircle() and tft_fillCircle().
+static void band_circle(short x0, short y0, short r, unsigned char fill,
+                        unsigned short color) {
+    short f = 1 - r;
+    short ddF_x = 1;
+    short ddF_y = -2 * r;
+    short x = 0;
+    short y = r;
+
+    if (fill) {
+        band_vspan(x0, y0 - r, y0 + r, color);
+    } else {
+        band_plot(x0, y0 + r, color);
+        band_plot(x0, y0 - r, color);
+        band_plot(x0 + r, y0, color);
+        band_plot(x0 - r, y0, color);
+    }
+
+    while (x < y) {
+        if (f >= 0) {
+            y--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+        x++;
+        ddF_x += 2;
+        f += ddF_x;
+
+        if (fill) {
+            band_vspan(x0 + x, y0 - y, y0 + y, color);
+            band_vspan(x0 - x, y0 - y, y0 + y, color);
+            band_vspan(x0 + y, y0 - x, y0 + x, color);
+            band_vspan(x0 - y, y0 - x, y0 + x, color);
+        } else {
+            band_plot(x0 + x, y0 + y, color);
+            band_plot(x0 - x, y0 + y, color);
+            band_plot(x0 + x, y0 - y, color);
+            band_plot(x0 - x, y0 - y, color);
+            band_plot(x0 + y, y0 + x, color);
+            band_plot(x0 - y, y0 + x, color);
+            band_plot(x0 + y, y0 - x, color);
+            band_plot(x0 - y, y0 - x, color);
+        }
+    }
+}
+
+// Renders the rows of a text primitive that fall in the current band.
+static void band_text(const struct prim *p) {
+    short row, y, x;
+    unsigned char bit, col, line;
+    const char *s;
+
+    for (y = p->top; y <= p->bottom; y++) {
+        if ((y < band_y0) || (y > band_y1))
+            continue;
+        row = (y - p->y0) / p->size;
+        bit = 1 << row;
+        x = p->x0;
+        for (s = p->str; *s; s++) {
+            for (col = 0; col < 6; col++, x += p->size) {
+                line = (col < 5) ? font[(unsigned char)*s * 5 + col] : 0;
+                if (line & bit)
+                    band_hspan(x, x + p->size - 1, y, p->color);
+                else if (p->bg != p->color)
+                    band_hspan(x, x + p->size - 1, y, p->bg);
+            }
+        }
+    }
+}
+
+static void band_render(const struct prim *p) {
+    short y;
+
+    switch (p->type) {
+        case PRIM_RECT:
+            for (y = p->y0; y <= p->y1; y++)
+                band_hspan(p->x0, p->x1, y, p->color);
+            break;
+        case PRIM_LINE:
+            band_line(p->x0, p->y0, p->x1, p->y1, p->color);
+            break;
+        case PRIM_CIRCLE:
+        case PRIM_FILL_CIRCLE:
+            band_circle(p->x0, p->y0, p->x1, p->type == PRIM_FILL_CIRCLE,
+                        p->color);
+            break;
+        case PRIM_TEXT:
+            band_text(p);
+            break;
+    }
+}
+
+// Appends a primitive touching rows top..bottom to the display list.
+static struct prim *band_add(unsigned char type, short top, short bottom,
+                             unsigned short color) {
+    struct prim *p;
+
+    if ((nprims >= TFT_BAND_MAX_PRIMS) || (bottom < reg_y) ||
+        (top > reg_y + reg_h - 1))
+        return NULL;
+    p = &prims[nprims++];
+    p->type = type;
+    p->top = top;
+    p->bottom = bottom;
+    p->color = color;
+    return p;
+}
+
+/**
+ *  Starts recording a frame that covers the rectangle with top left vertex
+ *  (x, y), width w and height h, on a background of color `bg`.
+ *
+ *  Primitives recorded with the tft_band... functions are drawn, in order,
+ *  when tft_bandFlush() is called; parts falling outside the rectangle are
+ *  clipped. If more than TFT_BAND_MAX_PRIMS primitives are recorded, the
+ *  extra ones are ignored.
+ *
+ *  Example:
+ *
+ *      tft_bandBegin(0, 0, tft_width(), 40, ILI9340_BLUE);
+ *      tft_bandFillCircle(20, 20, 15, ILI9340_RED);
+ *      tft_bandDrawText(40, 16, "Speed: 42", ILI9340_WHITE, ILI9340_WHITE, 1);
+ *      tft_bandFlush();
+ */
+void tft_bandBegin(short x, short y, short w, short h, unsigned short bg) {
+    if (x < _clip_x0) {
+        w -= _clip_x0 - x;
+        x = _clip_x0;
+    }
+    if (y < _clip_y0) {
+        h -= _clip_y0 - y;
+        y = _clip_y0;
+    }
+    if (x + w - 1 > _clip_x1)
+        w = _clip_x1 - x + 1;
+    if (y + h - 1 > _clip_y1)
+        h = _clip_y1 - y + 1;
+    if (w > TFT_BAND_PIXELS)
+        w = TFT_BAND_PIXELS;
+
+    reg_x = x;
+    reg_y = y;
+    reg_w = (w > 0) ? w : 0;
+    reg_h = (h > 0) ? h : 0;
+    reg_bg = bg;
+    nprims = 0;
+}
+
+/**
+ *  Records a filled rectangle; see tft_fillRect().
+ */
+void tft_bandFillRect(short x, short y, short w, short h,
+                      unsigned short color) {
+    struct prim *p;
+
+    if ((w <= 0) || (h <= 0))
+        return;
+    p = band_add(PRIM_RECT, y, y + h - 1, color);
+    if (p) {
+        p->x0 = x;
+        p->y0 = y;
+        p->x1 = x + w - 1;
+        p->y1 = y + h - 1;
+    }
+}
+
+/**
+ *  Records a rectangle outline; see tft_drawRect().
+ */
+void tft_bandDrawRect(short x, short y, short w, short h,
+                      unsigned short color) {
+    tft_bandDrawFastHLine(x, y, w, color);
+    tft_bandDrawFastHLine(x, y + h - 1, w, color);
+    tft_bandDrawFastVLine(x, y, h, color);
+    tft_bandDrawFastVLine(x + w - 1, y, h, color);
+}
+
+/**
+ *  Records a horizontal line; see tft_drawFastHLine().
+ */
+void tft_bandDrawFastHLine(short x, short y, short w, unsigned short color) {
+    tft_bandFillRect(x, y, w, 1, color);
+}
+
+/**
+ *  Records a vertical line; see tft_drawFastVLine().
+ */
+void tft_bandDrawFastVLine(short x, short y, short h, unsigned short color) {
+    tft_bandFillRect(x, y, 1, h, color);
+}
+
+/**
+ *  Records a straight line; see tft_drawLine().
+ */
+void tft_bandDrawLine(short x0, short y0, short x1, short y1,
+                      unsigned short color) {
+    struct prim *p;
+
+    p = band_add(PRIM_LINE, y0 < y1 ? y0 : y1, y0 < y1 ? y1 : y0, color);
+    if (p) {
+        p->x0 = x0;
+        p->y0 = y0;
+        p->x1 = x1;
+        p->y1 = y1;
+    }
+}
+
+/**
+ *  Records a circle outline; see tft_drawCircle().
+ */
+void tft_bandDrawCircle(short x0, short y0, short r, unsigned short color) {
+    struct prim *p;
+
+    p = band_add(PRIM_CIRCLE, y0 - r, y0 + r, color);
+    if (p) {
+        p->x0 = x0;
+        p->y0 = y0;
+        p->x1 = r;
+    }
+}
+
+/**
+ *  Records a filled circle; see tft_fillCircle().
+ */
+void tft_bandFillCircle(short x0, short y0, short r, unsigned short color) {
+    struct prim *p;
+
+    p = band_add(PRIM_FILL_CIRCLE, y0 - r, y0 + r, color);
+    if (p) {
+        p->x0 = x0;
+        p->y0 = y0;
+        p->x1 = r;
+    }
+}
+
+/**
+ *  Records a string drawn with the built-in font at (x, y) in the given
+ *  color, background color, and size; as with tft_drawChar(), a background
+ *  equal to `color` is transparent.
+ *
+ *  Only the pointer is recorded, so `str` must stay valid and unchanged
+ *  until tft_bandFlush(). No wrapping is done.
+ */
+void tft_bandDrawText(short x, short y, const char *str,
+                      unsigned short color, unsigned short bg,
+                      unsigned char size) {
+    struct prim *p;
+
+    if (size == 0)
+        size = 1;
+    p = band_add(PRIM_TEXT, y, y + 8 * size - 1, color);
+    if (p) {
+        p->x0 = x;
+        p->y0 = y;
+        p->bg = bg;
+        p->size = size;
+        p->str = str;
+    }
+}
+
+/**
+ *  Renders the recorded frame and sends it to the display, one band at a
+ *  time, all through a single address window.
+ */
+void tft_bandFlush(void) {
+    short rows = TFT_BAND_PIXELS / (reg_w ? reg_w : 1);
+    unsigned long i, n;
+    unsigned char k;
+
+    if ((reg_w == 0) || (reg_h == 0))
+        return;
+
+    tft_beginWrite();
+    tft_setWindow(reg_x, reg_y, reg_x + reg_w - 1, reg_y + reg_h - 1);
+    for (band_y0 = reg_y; band_y0 < reg_y + reg_h; band_y0 += rows) {
+        band_y1 = band_y0 + rows - 1;
+        if (band_y1 > reg_y + reg_h - 1)
+            band_y1 = reg_y + reg_h - 1;
+
+        n = (unsigned long)(band_y1 - band_y0 + 1) * reg_w;
+        for (i = 0; i < n; i++)
+            band_buf[i] = reg_bg;
+        for (k = 0; k < nprims; k++) {
+            if ((prims[k].bottom >= band_y0) && (prims[k].top <= band_y1))
+                band_render(&prims[k]);
+        }
+        tft_pushPixels(band_buf, n);
+    }
+    tft_endWrite();
+}
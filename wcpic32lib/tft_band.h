@@ -0,0 +1,41 @@
+#ifndef TFT_BAND_H
+#define TFT_BAND_H
+
+/**
+ *  @file   tft_band.h
+ *
+ *  @brief  A banded renderer for the TFT: primitives are recorded for a
+ *          frame, composited band by band in a RAM line buffer, and each
+ *          band is streamed to the display once.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *          Overlapping primitives cost nothing extra on the SPI bus, and
+ *          since every pixel of the frame is written exactly once, the
+ *          result is flicker-free even when shapes are layered.
+ *
+ *          The line buffer holds TFT_BAND_PIXELS pixels (default 320x16,
+ *          i.e. 10 KB of RAM); the display list holds TFT_BAND_MAX_PRIMS
+ *          primitives. Either may be changed by defining it when building
+ *          the library.
+ *
+ *  @author Jeff Lutgen
+ */
+
+void tft_bandBegin(short x, short y, short w, short h, unsigned short bg);
+void tft_bandFillRect(short x, short y, short w, short h,
+                      unsigned short color);
+void tft_bandDrawRect(short x, short y, short w, short h,
+                      unsigned short color);
+void tft_bandDrawFastHLine(short x, short y, short w, unsigned short color);
+void tft_bandDrawFastVLine(short x, short y, short h, unsigned short color);
+void tft_bandDrawLine(short x0, short y0, short x1, short y1,
+                      unsigned short color);
+void tft_bandDrawCircle(short x0, short y0, short r, unsigned short color);
+void tft_bandFillCircle(short x0, short y0, short r, unsigned short color);
+void tft_bandDrawText(short x, short y, const char *str,
+                      unsigned short color, unsigned short bg,
+                      unsigned char size);
+void tft_bandFlush(void);
+
+#endif // TFT_BAND_H
@@ -0,0 +1,182 @@
+/*
+ *  @file   tft_chart.c
+ *
+ *  @brief  A sweeping strip chart for the TFT, drawn one column per
+ *          sample.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include "tft_chart.h"
+#include "tft_master.h"
+#include "private/tft_counters.h"
+
+#define COL_MAX 320     // tallest chart: the longer side of the display
+
+static unsigned short col_buf[COL_MAX];
+
+/**
+ *  Sets up `chart` to cover the rectangle with top-left vertex (x, y),
+ *  width w and height h, showing values from vmin (bottom row) to vmax
+ *  (top row) over background color `bg`. The chart starts with no grid
+ *  and no traces; add them, then call tft_chartClear() to draw it.
+ *
+ *  Example:
+ *
+ *      static struct tft_chart scope;
+ *      static short v[2];
+ *
+ *      tft_chartInit(&scope, 0, 40, 320, 200, 0, 1023, ILI9340_BLACK);
+ *      tft_chartGrid(&scope, 40, 25, 0x2104);
+ *      tft_chartAddTrace(&scope, ILI9340_YELLOW);
+ *      tft_chartAddTrace(&scope, ILI9340_CYAN);
+ *      tft_chartClear(&scope);
+ *      while (1) {
+ *          v[0] = ReadADC10(0);
+ *          v[1] = ReadADC10(1);
+ *          tft_chartAdd(&scope, v);
+ *      }
+ */
+void tft_chartInit(struct tft_chart *chart, short x, short y, short w,
+                   short h, short vmin, short vmax, unsigned short bg) {
+    if (w > TFT_CHART_MAX_WIDTH)
+        w = TFT_CHART_MAX_WIDTH;
+    if (h > COL_MAX)
+        h = COL_MAX;
+    chart->x = x;
+    chart->y = y;
+    chart->w = (w > 0) ? w : 0;
+    chart->h = (h > 0) ? h : 0;
+    chart->vmin = vmin;
+    chart->vmax = (vmax > vmin) ? vmax : vmin + 1;
+    chart->bg = bg;
+    chart->grid = bg;
+    chart->grid_dx = 0;
+    chart->grid_dy = 0;
+    chart->ntraces = 0;
+    chart->col = 0;
+}
+
+/**
+ *  Gives `chart` a grid of the given color, with vertical lines every dx
+ *  columns and horizontal lines every dy rows, starting from its top left
+ *  corner. Either spacing may be 0 for no lines in that direction.
+ */
+void tft_chartGrid(struct tft_chart *chart, short dx, short dy,
+                   unsigned short color) {
+    chart->grid_dx = (dx > 0) ? dx : 0;
+    chart->grid_dy = (dy > 0) ? dy : 0;
+    chart->grid = color;
+}
+
+/**
+ *  Adds a trace of the given color to `chart`, and returns its index in
+ *  the values passed to tft_chartAdd(), or -1 if the chart already has
+ *  TFT_CHART_MAX_TRACES traces. Traces with higher indexes are drawn on
+ *  top.
+ */
+int tft_chartAddTrace(struct tft_chart *chart, unsigned short color) {
+    if (chart->ntraces == TFT_CHART_MAX_TRACES)
+        return -1;
+    chart->color[chart->ntraces] = color;
+    return chart->ntraces++;
+}
+
+/**
+ *  Draws the background and grid of `chart`, and starts the sweep over at
+ *  the left edge.
+ */
+void tft_chartClear(struct tft_chart *chart) {
+    short i;
+
+    tft_beginWrite();
+    tft_fillRect(chart->x, chart->y, chart->w, chart->h, chart->bg);
+    if (chart->grid_dx) {
+        for (i = 0; i < chart->w; i += chart->grid_dx)
+            tft_drawFastVLine(chart->x + i, chart->y, chart->h, chart->grid);
+    }
+    if (chart->grid_dy) {
+        for (i = 0; i < chart->h; i += chart->grid_dy)
+            tft_drawFastHLine(chart->x, chart->y + i, chart->w, chart->grid);
+    }
+    tft_endWrite();
+
+    for (i = 0; i < chart->w; i++) {
+        chart->lo[i] = chart->h;
+        chart->hi[i] = -1;
+    }
+    chart->col = 0;
+}
+
+/**
+ *  Plots the next sample: values[k] for each trace k, in the range given
+ *  to tft_chartInit() (values outside it are pinned to the top or bottom
+ *  row). Each trace is drawn as a vertical segment joining its previous
+ *  sample to this one.
+ */
+void tft_chartAdd(struct tft_chart *chart, const short *values) {
+    short col = chart->col, lo, hi, nlo, nhi, r, a, b, g;
+    short span_lo[TFT_CHART_MAX_TRACES], span_hi[TFT_CHART_MAX_TRACES];
+    unsigned char k;
+    long v;
+    TFT_STAT_PRIM(CHART);
+
+    if ((chart->w == 0) || (chart->h == 0))
+        return;
+
+    // Rows each trace covers in this column
+    nlo = chart->h;
+    nhi = -1;
+    for (k = 0; k < chart->ntraces; k++) {
+        v = values[k];
+        if (v < chart->vmin)
+            v = chart->vmin;
+        if (v > chart->vmax)
+            v = chart->vmax;
+        r = chart->h - 1 - (v - chart->vmin) * (chart->h - 1) /
+                           ((long)chart->vmax - chart->vmin);
+        a = b = r;
+        if (col > 0) {
+            if (chart->prev[k] < a)
+                a = chart->prev[k];
+            else
+                b = chart->prev[k];
+        }
+        chart->prev[k] = r;
+        span_lo[k] = a;
+        span_hi[k] = b;
+        if (a < nlo)
+            nlo = a;
+        if (b > nhi)
+            nhi = b;
+    }
+
+    // Send the rows that were drawn on before or are now
+    lo = (chart->lo[col] < nlo) ? chart->lo[col] : nlo;
+    hi = (chart->hi[col] > nhi) ? chart->hi[col] : nhi;
+    if (lo <= hi) {
+        if (chart->grid_dx && (col % chart->grid_dx == 0)) {
+            for (r = lo; r <= hi; r++)
+                col_buf[r - lo] = chart->grid;
+        } else {
+            g = chart->grid_dy ? lo % chart->grid_dy : 1;
+            for (r = lo; r <= hi; r++) {
+                col_buf[r - lo] = (g == 0) ? chart->grid : chart->bg;
+                if (++g == chart->grid_dy)
+                    g = 0;
+            }
+        }
+        for (k = 0; k < chart->ntraces; k++) {
+            for (r = span_lo[k]; r <= span_hi[k]; r++)
+                col_buf[r - lo] = chart->color[k];
+        }
+        tft_setWindow(chart->x + col, chart->y + lo, chart->x + col,
+                      chart->y + hi);
+        tft_pushPixels(col_buf, hi - lo + 1);
+    }
+    chart->lo[col] = nlo;
+    chart->hi[col] = nhi;
+    chart->col = (col + 1 < chart->w) ? col + 1 : 0;
+}
@@ -0,0 +1,58 @@
+#ifndef TFT_CHART_H
+#define TFT_CHART_H
+
+/**
+ *  @file   tft_chart.h
+ *
+ *  @brief  A sweeping strip chart for the TFT, drawn one column per
+ *          sample.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *          Each new sample (one value per trace) goes in the column after
+ *          the previous one, wrapping around at the right edge like an
+ *          oscilloscope sweep. The chart remembers which rows of each
+ *          column it has drawn on, so a sample only sends the rows that
+ *          change: the old traces in that column are erased and the new
+ *          ones drawn in a single one-pixel-wide window, with the grid
+ *          restored underneath. Nothing else is ever redrawn, so there is
+ *          no flicker.
+ *
+ *          A chart has up to TFT_CHART_MAX_TRACES traces (default 4) and
+ *          is at most TFT_CHART_MAX_WIDTH (default 320) pixels wide. Either
+ *          may be changed by defining it, both when building the library
+ *          and in code that uses it.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#ifndef TFT_CHART_MAX_TRACES
+#define TFT_CHART_MAX_TRACES    4
+#endif
+
+#ifndef TFT_CHART_MAX_WIDTH
+#define TFT_CHART_MAX_WIDTH     320
+#endif
+
+struct tft_chart {
+    short x, y, w, h;
+    short vmin, vmax;           // values shown at the bottom and top rows
+    unsigned short bg, grid;
+    short grid_dx, grid_dy;     // grid spacing in pixels, 0 for none
+    unsigned char ntraces;
+    unsigned short color[TFT_CHART_MAX_TRACES];
+    short prev[TFT_CHART_MAX_TRACES];   // row of each trace's last sample
+    short col;                          // column for the next sample
+    short lo[TFT_CHART_MAX_WIDTH];      // rows drawn on in each column
+    short hi[TFT_CHART_MAX_WIDTH];      // (none if lo > hi)
+};
+
+void tft_chartInit(struct tft_chart *chart, short x, short y, short w,
+                   short h, short vmin, short vmax, unsigned short bg);
+void tft_chartGrid(struct tft_chart *chart, short dx, short dy,
+                   unsigned short color);
+int tft_chartAddTrace(struct tft_chart *chart, unsigned short color);
+void tft_chartClear(struct tft_chart *chart);
+void tft_chartAdd(struct tft_chart *chart, const short *values);
+
+#endif // TFT_CHART_H
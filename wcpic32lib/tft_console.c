@@ -0,0 +1,259 @@
+/*
+ *  @file   tft_console.c
+ *
+ *  @brief  A scrolling text console for the TFT, using the ILI9340's
+ *          hardware vertical scrolling.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include "tft_console.h"
+#include "tft_gfx.h"
+#include "tft_master.h"
+
+#define PANEL_LINES 320     // scrollable dimension of the panel
+#define ESC         '\x1b'
+
+// 5-6-5 equivalents of the eight ANSI colors (SGR 30-37 and 40-47)
+static const unsigned short ansi_colors[8] = {
+    ILI9340_BLACK, ILI9340_RED, ILI9340_GREEN, ILI9340_YELLOW,
+    ILI9340_BLUE, ILI9340_MAGENTA, ILI9340_CYAN, ILI9340_WHITE
+};
+
+static short con_top;           // first line of the scrolling area
+static short con_rows, con_cols;
+static short line_h, char_w;
+static unsigned char con_size;
+static unsigned short con_color, con_bg;
+static unsigned short def_color, def_bg;
+
+// Text row r (0 = top of the console) lives in frame memory row
+// (first + r) % con_rows, so scrolling just advances `first`.
+static short first;
+static short row, col;          // cursor
+
+// VT100 escape sequence parser. Arguments past the first ESC_MAX_ARGS are
+// counted but not kept.
+#define ESC_MAX_ARGS    4
+static enum { ESC_NONE, ESC_START, ESC_CSI } esc_state;
+static short esc_arg[ESC_MAX_ARGS];
+static unsigned char esc_nargs;
+
+// Returns the y coordinate of text row r in frame memory.
+static short row_y(short r) {
+    return con_top + ((first + r) % con_rows) * line_h;
+}
+
+static void clear_cols(short r, short c0, short c1) {
+    if (c1 > con_cols)
+        c1 = con_cols;
+    if (c0 < c1)
+        tft_fillRect(c0 * char_w, row_y(r), (c1 - c0) * char_w, line_h,
+                     con_bg);
+}
+
+static void newline(void) {
+    col = 0;
+    if (row < con_rows - 1) {
+        row++;
+        return;
+    }
+    // The top text row becomes the new bottom one: erase it, then scroll.
+    clear_cols(0, 0, con_cols);
+    first = (first + 1) % con_rows;
+    tft_scrollTo(con_top + first * line_h);
+}
+
+static short clamp(short v, short lo, short hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static void set_attributes(short n) {
+    if (n == 0) {
+        con_color = def_color;
+        con_bg = def_bg;
+    } else if (n >= 30 && n <= 37) {
+        con_color = ansi_colors[n - 30];
+    } else if (n >= 40 && n <= 47) {
+        con_bg = ansi_colors[n - 40];
+    }
+}
+
+// Carries out the control sequence ESC [ args c.
+static void csi(char c) {
+    short n = esc_arg[0] ? esc_arg[0] : 1;
+    unsigned char i;
+
+    switch (c) {
+        case 'A':
+            row = clamp(row - n, 0, con_rows - 1);
+            break;
+        case 'B':
+            row = clamp(row + n, 0, con_rows - 1);
+            break;
+        case 'C':
+            col = clamp(col + n, 0, con_cols - 1);
+            break;
+        case 'D':
+            col = clamp(col - n, 0, con_cols - 1);
+            break;
+        case 'H':
+        case 'f':
+            row = clamp(n - 1, 0, con_rows - 1);
+            col = clamp((esc_arg[1] ? esc_arg[1] : 1) - 1, 0, con_cols - 1);
+            break;
+        case 'J':
+            if (esc_arg[0] == 2)
+                tft_consoleClear();
+            break;
+        case 'K':
+            if (esc_arg[0] == 0)
+                clear_cols(row, col, con_cols);
+            else if (esc_arg[0] == 1)
+                clear_cols(row, 0, col + 1);
+            else
+                clear_cols(row, 0, con_cols);
+            break;
+        case 'm':
+            for (i = 0; (i < esc_nargs) && (i < ESC_MAX_ARGS); i++)
+                set_attributes(esc_arg[i]);
+            break;
+    }
+}
+
+/**
+ *  Sets up the console and clears it.
+ *
+ *  The first `top` and last `bottom` lines of the (portrait) screen are left
+ *  alone, e.g. for a status bar; the rest scrolls. Text is drawn with the
+ *  given size (1 is smallest), color, and background color `bg`.
+ *
+ *  If the margins leave less than one line of text, they are reduced
+ *  (`bottom` first) until one fits; the size is limited to 40, one
+ *  character per line.
+ *
+ *  Example:
+ *
+ *      tft_init();
+ *      tft_consoleInit(0, 0, 1, ILI9340_GREEN, ILI9340_BLACK);
+ *      tft_consoleWrite("\x1b[33mwarning:\x1b[0m battery low\n");
+ */
+void tft_consoleInit(short top, short bottom, unsigned char size,
+                     unsigned short color, unsigned short bg) {
+    tft_setRotation(0);
+
+    con_size = (size > 0) ? size : 1;
+    if (6 * con_size > tft_width())     // at least one column
+        con_size = tft_width() / 6;
+    line_h = 8 * con_size;
+    char_w = 6 * con_size;
+    // Shrink margins that leave less than one text row
+    if (top < 0)
+        top = 0;
+    if (top > PANEL_LINES - line_h)
+        top = PANEL_LINES - line_h;
+    if (bottom < 0)
+        bottom = 0;
+    if (bottom > PANEL_LINES - top - line_h)
+        bottom = PANEL_LINES - top - line_h;
+    con_top = top;
+    con_rows = (PANEL_LINES - top - bottom) / line_h;
+    con_cols = tft_width() / char_w;
+    // Any leftover lines join the fixed bottom area, so that the scrolling
+    // area holds exactly con_rows text rows.
+    bottom = PANEL_LINES - top - con_rows * line_h;
+    tft_setScrollArea(top, bottom);
+
+    con_color = def_color = color;
+    con_bg = def_bg = bg;
+    esc_state = ESC_NONE;
+    tft_consoleClear();
+}
+
+/**
+ *  Clears the console and moves the cursor to its top left corner.
+ */
+void tft_consoleClear(void) {
+    first = 0;
+    row = col = 0;
+    tft_scrollTo(con_top);
+    tft_fillRect(0, con_top, tft_width(), con_rows * line_h, con_bg);
+}
+
+/**
+ *  Prints one character on the console, scrolling if needed.
+ *
+ *  `\n` moves to the start of the next line, `\r` to the start of the
+ *  current one, `\b` back one column and `\t` to the next tab stop.
+ *  Escape sequences are described in tft_console.h.
+ *
+ *  To mirror a UART debug stream, pass it each character that is sent or
+ *  received.
+ */
+void tft_consolePutc(char c) {
+    switch (esc_state) {
+        case ESC_START:
+            if (c == '[') {
+                esc_state = ESC_CSI;
+                esc_arg[0] = esc_arg[1] = 0;
+                esc_nargs = 1;
+            } else {
+                esc_state = ESC_NONE;
+            }
+            return;
+        case ESC_CSI:
+            if (c >= '0' && c <= '9') {
+                if (esc_nargs <= ESC_MAX_ARGS && esc_arg[esc_nargs - 1] < 1000)
+                    esc_arg[esc_nargs - 1] = esc_arg[esc_nargs - 1] * 10 + c - '0';
+            } else if (c == ';') {
+                if (esc_nargs < 255)
+                    esc_nargs++;
+                if (esc_nargs <= ESC_MAX_ARGS)
+                    esc_arg[esc_nargs - 1] = 0;
+            } else {
+                csi(c);
+                esc_state = ESC_NONE;
+            }
+            return;
+        default:
+            break;
+    }
+
+    switch (c) {
+        case ESC:
+            esc_state = ESC_START;
+            break;
+        case '\n':
+            newline();
+            break;
+        case '\r':
+            col = 0;
+            break;
+        case '\b':
+            if (col > 0)
+                col--;
+            break;
+        case '\t':
+            col = (col / tabspace + 1) * tabspace;
+            if (col >= con_cols)
+                newline();
+            break;
+        default:
+            if (col >= con_cols)
+                newline();
+            tft_drawChar(col * char_w, row_y(row), c, con_color, con_bg,
+                         con_size);
+            col++;
+            break;
+    }
+}
+
+/**
+ *  Prints a null-terminated string on the console; see tft_consolePutc().
+ */
+void tft_consoleWrite(const char *str) {
+    while (*str)
+        tft_consolePutc(*str++);
+}
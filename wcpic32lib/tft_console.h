@@ -0,0 +1,35 @@
+#ifndef TFT_CONSOLE_H
+#define TFT_CONSOLE_H
+
+/**
+ *  @file   tft_console.h
+ *
+ *  @brief  A scrolling text console for the TFT, using the ILI9340's
+ *          hardware vertical scrolling.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *          Scrolling by one line costs a single command plus erasing that
+ *          line, so the console keeps up with a UART debug stream at full
+ *          baud rate. A subset of VT100 escape sequences is understood:
+ *
+ *              ESC[nA  ESC[nB  ESC[nC  ESC[nD   cursor up/down/right/left
+ *              ESC[r;cH  ESC[r;cf               cursor position (1-based)
+ *              ESC[K  ESC[1K  ESC[2K            clear to end/start/all of line
+ *              ESC[2J                           clear console
+ *              ESC[0m  ESC[3xm  ESC[4xm         reset, foreground, background
+ *              ESC[0;3x;4xm                     combined, up to 4 arguments
+ *
+ *          Hardware scrolling runs along the long side of the panel, so
+ *          the console puts the display in rotation 0 (portrait).
+ *
+ *  @author Jeff Lutgen
+ */
+
+void tft_consoleInit(short top, short bottom, unsigned char size,
+                     unsigned short color, unsigned short bg);
+void tft_consolePutc(char c);
+void tft_consoleWrite(const char *str);
+void tft_consoleClear(void);
+
+#endif // TFT_CONSOLE_H
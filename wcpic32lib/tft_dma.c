@@ -0,0 +1,239 @@
+/*
+ *  @file   tft_dma.c
+ *
+ *  @brief  Non-blocking, DMA-driven bulk pixel transfers to the TFT.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include <xc.h>
+#include <sys/attribs.h>        // For __ISR macro
+#include "private/common.h"
+#include "private/tft_spi.h"
+#include "private/tft_sink.h"
+#include "tft_master.h"
+#include "tft_dma.h"
+
+#define TFT_DMA_CHN     DMA_CHANNEL3
+#define TFT_DMA_VECTOR  _DMA_3_VECTOR
+
+// The PIC32 DMA controller has no "don't increment source" mode, and a
+// block ends after the larger of the source and destination sizes, which
+// for SPI1BUF is 2 bytes. So a constant color is sent by repeatedly
+// transferring a RAM block filled with that color, at one interrupt per
+// block: 150 for a full-screen fill at 512 pixels.
+#ifndef TFT_DMA_FILL_PIXELS
+#define TFT_DMA_FILL_PIXELS 512
+#endif
+
+// DCHxSSIZ is 16 bits on the PIC32MX1xx/2xx, so a single block can move at
+// most this many pixels.
+#define MAX_BLOCK_PIXELS 32767
+
+static unsigned short fill_buf[TFT_DMA_FILL_PIXELS];
+
+static const unsigned short *src;   // source of the next block
+static unsigned long remaining;     // pixels not yet handed to the DMA
+static unsigned char constant;      // nonzero: resend fill_buf every block
+static unsigned char initialized;
+static tft_dma_callback callback;
+
+static void tft_dmaOpen(void) {
+    DmaChnOpen(TFT_DMA_CHN, DMA_CHN_PRI3, DMA_OPEN_DEFAULT);
+    // Move one cell each time SPI1's transmit FIFO has room (SPI1 is opened
+    // with SPI_OPEN_TBE_NOT_FULL, so its transmit event means "not full").
+    DmaChnSetEventControl(TFT_DMA_CHN,
+                          DMA_EV_START_IRQ_EN | DMA_EV_START_IRQ(_SPI1_TX_IRQ));
+    DmaChnSetEvEnableFlags(TFT_DMA_CHN, DMA_EV_BLOCK_DONE);
+
+    INTSetVectorPriority(INT_VECTOR_DMA(TFT_DMA_CHN), INT_PRIORITY_LEVEL_5);
+    INTSetVectorSubPriority(INT_VECTOR_DMA(TFT_DMA_CHN),
+                            INT_SUB_PRIORITY_LEVEL_0);
+    INTClearFlag(INT_SOURCE_DMA(TFT_DMA_CHN));
+    INTEnable(INT_SOURCE_DMA(TFT_DMA_CHN), INT_ENABLED);
+    initialized = 1;
+}
+
+/*
+ *  Hands the next block of at most TFT_DMA_FILL_PIXELS (constant color) or
+ *  MAX_BLOCK_PIXELS (pixel buffer) pixels to the DMA channel.
+ */
+static void tft_dmaNextBlock(void) {
+    unsigned long n = constant ? TFT_DMA_FILL_PIXELS : MAX_BLOCK_PIXELS;
+
+    if (n > remaining)
+        n = remaining;
+    DmaChnSetTxfer(TFT_DMA_CHN, src, (void *)&SPI1BUF, n * 2, 2, 2);
+    remaining -= n;
+    if (!constant)
+        src += n;
+
+    DmaChnEnable(TFT_DMA_CHN);
+    // The FIFO became not-full while the channel was idle, so that event
+    // is gone; push the first cell by hand. It needs just one free entry,
+    // which the FIFO nearly always has, so this runs in the interrupt
+    // without waiting for the FIFO to drain.
+    while (TxBufFullSPI1()) { ; }
+    DmaChnStartTxfer(TFT_DMA_CHN, DMA_WAIT_NOT, 0);
+}
+
+/*
+ *  Sets up the window for (x, y, w, h), which must already be clipped, and
+ *  starts streaming w*h pixels from `pixels`.
+ */
+static void tft_dmaStart(short x, short y, short w, short h,
+                         const unsigned short *pixels, unsigned char fill,
+                         tft_dma_callback done) {
+    if (_tft_sink) {    // drawing into a framebuffer: nothing to wait for
+        tft_setWindow(x, y, x+w-1, y+h-1);
+        if (fill)
+            tft_pushColorN(pixels[0], (unsigned long)w * h);
+        else
+            tft_pushPixels(pixels, (unsigned long)w * h);
+        if (done)
+            done();
+        return;
+    }
+
+    if (!initialized)
+        tft_dmaOpen();
+
+    tft_setWindow(x, y, x+w-1, y+h-1);
+    tft_windowWritten((unsigned long)w * h);
+
+    src = pixels;
+    remaining = (unsigned long)w * h;
+    constant = fill;
+    callback = done;
+    _tft_dma_busy = 1;
+
+    _dc_high();
+    _cs_low();
+    tft_dmaNextBlock();
+}
+
+void __ISR(TFT_DMA_VECTOR, IPL5SOFT) tft_dmaHandler(void) {
+    DmaChnClrEvFlags(TFT_DMA_CHN, DMA_EV_ALL_EVNTS);
+    INTClearFlag(INT_SOURCE_DMA(TFT_DMA_CHN));
+
+    if (remaining) {
+        tft_dmaNextBlock();
+        return;
+    }
+
+    // The last word is still being shifted out.
+    while (SPI1STATbits.SPIBUSY) { ; }
+    _cs_high();
+    _tft_dma_busy = 0;
+    if (callback)
+        callback();
+}
+
+/**
+ *  Starts filling the rectangle with top-left vertex (x, y), width w and
+ *  height h with the given color, and returns immediately.
+ *
+ *  If `done` is not NULL, it is called from the DMA interrupt when the
+ *  fill is complete (or right away if the rectangle is entirely off
+ *  screen).
+ *
+ *  Example:
+ *
+ *      tft_fillRectDMA(0, 0, 100, 50, ILI9340_BLUE, NULL);
+ *      // ... do other work ...
+ *      tft_dmaWait();
+ */
+void tft_fillRectDMA(short x, short y, short w, short h, unsigned short color,
+                     tft_dma_callback done) {
+    unsigned long i, n;
+
+    tft_dmaWait();  // fill_buf may still be in use
+
+    if (x < _clip_x0) {
+        w -= _clip_x0 - x;
+        x = _clip_x0;
+    }
+    if (y < _clip_y0) {
+        h -= _clip_y0 - y;
+        y = _clip_y0;
+    }
+    if (x + w - 1 > _clip_x1)
+        w = _clip_x1 - x + 1;
+    if (y + h - 1 > _clip_y1)
+        h = _clip_y1 - y + 1;
+    if ((w <= 0) || (h <= 0)) {
+        if (done)
+            done();
+        return;
+    }
+
+    n = (unsigned long)w * h;
+    if (n > TFT_DMA_FILL_PIXELS)
+        n = TFT_DMA_FILL_PIXELS;
+    for (i = 0; i < n; i++)
+        fill_buf[i] = color;
+    tft_dmaStart(x, y, w, h, fill_buf, 1, done);
+}
+
+/**
+ *  Starts filling the entire screen (or clip rectangle, if smaller) with
+ *  the given color, and returns immediately. See tft_fillRectDMA().
+ */
+void tft_fillScreenDMA(unsigned short color, tft_dma_callback done) {
+    tft_fillRectDMA(_clip_x0, _clip_y0, _clip_x1 - _clip_x0 + 1,
+                    _clip_y1 - _clip_y0 + 1, color, done);
+}
+
+/**
+ *  Starts copying w*h pixels (5-6-5 RGB, row by row) from `pixels` into the
+ *  rectangle with top-left vertex (x, y), width w and height h, and returns
+ *  immediately.
+ *
+ *  `pixels` may be in RAM or flash, and must stay valid and unchanged until
+ *  the transfer is complete. If `done` is not NULL, it is called from the
+ *  DMA interrupt when the transfer is complete.
+ *
+ *  A rectangle that is only partly inside the clip rectangle (see
+ *  tft_pushClip()) is drawn without DMA, sending just its visible pixels,
+ *  before this returns.
+ */
+void tft_writeRectDMA(short x, short y, short w, short h,
+                      const unsigned short *pixels, tft_dma_callback done) {
+    tft_dmaWait();
+
+    if ((w <= 0) || (h <= 0) || (x > _clip_x1) || (y > _clip_y1) ||
+        (x + w - 1 < _clip_x0) || (y + h - 1 < _clip_y0)) {
+        if (done)
+            done();
+        return;
+    }
+    if ((x < _clip_x0) || (y < _clip_y0) ||
+        (x + w - 1 > _clip_x1) || (y + h - 1 > _clip_y1)) {
+        tft_setWindow(x, y, x+w-1, y+h-1);
+        tft_pushPixels(pixels, (unsigned long)w * h);
+        if (done)
+            done();
+        return;
+    }
+
+    tft_dmaStart(x, y, w, h, pixels, 0, done);
+}
+
+/**
+ *  Returns nonzero if a DMA transfer to the TFT is in progress.
+ */
+int tft_dmaBusy(void) {
+    return _tft_dma_busy;
+}
+
+/**
+ *  Blocks until any DMA transfer to the TFT has finished.
+ *
+ *  Must not be called with interrupts disabled, or from an interrupt
+ *  of priority 5 or higher.
+ */
+void tft_dmaWait(void) {
+    tft_waitDMA();
+}
@@ -0,0 +1,38 @@
+#ifndef TFT_DMA_H
+#define TFT_DMA_H
+
+/**
+ *  @file   tft_dma.h
+ *
+ *  @brief  Non-blocking, DMA-driven bulk pixel transfers to the TFT.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *          DMA channel 3 feeds SPI1 (triggered by the SPI1 transmit
+ *          interrupt event), so large fills and image blits proceed while
+ *          the CPU does other work. The end of each transfer is handled in
+ *          the DMA channel 3 interrupt, so multi-vector interrupts must be
+ *          enabled (`INTEnableSystemMultiVectoredInt()`) before starting a
+ *          transfer.
+ *
+ *          While a transfer is in progress the TFT owns SPI1; any other
+ *          tft_ function waits for the transfer to finish before it touches
+ *          the display.
+ *
+ *  @author Jeff Lutgen
+ */
+
+/**
+ *  Function called (from interrupt context) when a DMA transfer finishes.
+ */
+typedef void (*tft_dma_callback)(void);
+
+void tft_fillRectDMA(short x, short y, short w, short h, unsigned short color,
+                     tft_dma_callback done);
+void tft_fillScreenDMA(unsigned short color, tft_dma_callback done);
+void tft_writeRectDMA(short x, short y, short w, short h,
+                      const unsigned short *pixels, tft_dma_callback done);
+int tft_dmaBusy(void);
+void tft_dmaWait(void);
+
+#endif // TFT_DMA_H
@@ -0,0 +1,318 @@
+/*
+ *  @file   tft_fb.c
+ *
+ *  @brief  An indexed-color (1, 2 or 4 bits per pixel) shadow framebuffer
+ *          for the TFT, flushed to the display as changed spans only.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include <stdlib.h>
+#include "private/tft_sink.h"
+#include "tft_master.h"
+#include "tft_fb.h"
+
+// Tallest framebuffer supported (one dirty span is kept per row)
+#ifndef TFT_FB_MAX_ROWS
+#define TFT_FB_MAX_ROWS 320
+#endif
+
+#define MAX_LINE    320 // widest span sent to the display, in pixels
+
+static unsigned char *fb;
+static short fb_w, fb_h, fb_stride;
+static unsigned char fb_bpp, fb_mask;
+static const unsigned short *fb_palette;
+
+// Where the framebuffer appears on the display
+static short fb_x, fb_y;
+static unsigned char fb_scale = 1;
+
+// Columns changed since the last flush, per row; dirty_x0 > dirty_x1 when
+// the row is clean.
+static short dirty_x0[TFT_FB_MAX_ROWS], dirty_x1[TFT_FB_MAX_ROWS];
+
+// Window set through tft_setWindow() while redirected, and the position
+// the next pushed pixel goes to
+static short win_x0, win_y0, win_x1, win_y1;
+static short cur_x, cur_y;
+
+// Display size, saved while tft_width()/tft_height() report ours
+static unsigned short screen_w, screen_h;
+static unsigned char active;
+
+// Last color looked up, and its palette index
+static unsigned short last_color;
+static unsigned char last_index, last_valid;
+
+static unsigned short line_buf[MAX_LINE];
+
+// Returns the palette index of the entry closest to color.
+static unsigned char fb_index(unsigned short color) {
+    unsigned char i, best = 0;
+    long d, best_d = 0x7FFFFFFF;
+    short dr, dg, db;
+
+    if (last_valid && (color == last_color))
+        return last_index;
+
+    for (i = 0; i <= fb_mask; i++) {
+        if (fb_palette[i] == color) {
+            best = i;
+            break;
+        }
+        dr = (short)(color >> 11) - (fb_palette[i] >> 11);
+        dg = (short)((color >> 5) & 0x3F) - ((fb_palette[i] >> 5) & 0x3F);
+        db = (short)(color & 0x1F) - (fb_palette[i] & 0x1F);
+        d = 4L * dr * dr + (long)dg * dg + 4L * db * db;
+        if (d < best_d) {
+            best_d = d;
+            best = i;
+        }
+    }
+
+    last_color = color;
+    last_index = best;
+    last_valid = 1;
+    return best;
+}
+
+// Stores index idx at (x, y), which must be inside the framebuffer,
+// marking the pixel dirty only if its value changes.
+static inline void fb_put(short x, short y, unsigned char idx) {
+    unsigned short bit = x * fb_bpp;
+    unsigned char *p = fb + y * fb_stride + (bit >> 3);
+    unsigned char shift = bit & 7;
+    unsigned char v = idx << shift;
+    unsigned char mask = fb_mask << shift;
+
+    if ((*p & mask) == v)
+        return;
+    *p = (*p & ~mask) | v;
+    if (x < dirty_x0[y])
+        dirty_x0[y] = x;
+    if (x > dirty_x1[y])
+        dirty_x1[y] = x;
+}
+
+static inline unsigned char fb_get(short x, short y) {
+    unsigned short bit = x * fb_bpp;
+
+    return (fb[y * fb_stride + (bit >> 3)] >> (bit & 7)) & fb_mask;
+}
+
+/*
+ *  The sink functions. tft_master.c has already clipped single pixels;
+ *  windows are clipped here, pixel by pixel.
+ */
+
+static void fb_drawPixel(short x, short y, unsigned short color) {
+    fb_put(x, y, fb_index(color));
+}
+
+static void fb_setWindow(short x0, short y0, short x1, short y1) {
+    win_x0 = x0;
+    win_y0 = y0;
+    win_x1 = x1;
+    win_y1 = y1;
+    cur_x = x0;
+    cur_y = y0;
+}
+
+// Stores one pixel at the window position and advances it.
+static inline void fb_windowPut(unsigned char idx) {
+    if ((cur_x >= 0) && (cur_x < fb_w) && (cur_y >= 0) && (cur_y < fb_h))
+        fb_put(cur_x, cur_y, idx);
+    if (++cur_x > win_x1) {
+        cur_x = win_x0;
+        if (++cur_y > win_y1)
+            cur_y = win_y0;
+    }
+}
+
+static void fb_pushPixels(const unsigned short *buf, unsigned long n) {
+    while (n--)
+        fb_windowPut(fb_index(*buf++));
+}
+
+static void fb_pushColorN(unsigned short color, unsigned long n) {
+    unsigned char idx = fb_index(color);
+
+    while (n--)
+        fb_windowPut(idx);
+}
+
+static void fb_readRect(short x, short y, short w, short h,
+                        unsigned short *buf) {
+    short i, j;
+
+    for (j = y; j < y + h; j++)
+        for (i = x; i < x + w; i++)
+            *buf++ = fb_palette[fb_get(i, j)];
+}
+
+static const struct tft_sink fb_sink = {
+    fb_drawPixel, fb_setWindow, fb_pushPixels, fb_pushColorN, fb_readRect
+};
+
+/**
+ *  Sets up a w x h framebuffer with bpp (1, 2 or 4) bits per pixel in
+ *  `buf`, which must hold TFT_FB_BYTES(w, h, bpp) bytes. `palette` holds
+ *  the 2^bpp colors (5-6-5 RGB) that the pixel values stand for; it is
+ *  not copied, so must stay valid.
+ *
+ *  The framebuffer starts out filled with palette entry 0 and entirely
+ *  dirty, and is placed at the top left corner of the display at scale 1.
+ *
+ *  Example:
+ *
+ *      static unsigned char fb[TFT_FB_BYTES(320, 240, 2)];
+ *      static const unsigned short pal[4] = {
+ *          ILI9340_BLACK, ILI9340_WHITE, ILI9340_RED, ILI9340_GREEN
+ *      };
+ *
+ *      tft_setRotation(1);
+ *      tft_fbInit(fb, 320, 240, 2, pal);
+ *      tft_fbBegin();
+ *      while (1) {
+ *          draw_dashboard();   // draws the whole screen, as usual
+ *          tft_fbFlush();      // sends only what changed
+ *      }
+ */
+void tft_fbInit(unsigned char *buf, short w, short h, unsigned char bpp,
+                const unsigned short *palette) {
+    unsigned long i, n = TFT_FB_BYTES(w, h, bpp);
+
+    if (h > TFT_FB_MAX_ROWS)
+        h = TFT_FB_MAX_ROWS;
+    fb = buf;
+    fb_w = w;
+    fb_h = h;
+    fb_bpp = bpp;
+    fb_mask = (1 << bpp) - 1;
+    fb_stride = (w * bpp + 7) / 8;
+    fb_palette = palette;
+    last_valid = 0;
+
+    for (i = 0; i < n; i++)
+        fb[i] = 0;
+    tft_fbPlace(0, 0, 1);
+    if (active) {
+        _width = fb_w;
+        _height = fb_h;
+        tft_resetClip();
+    }
+}
+
+/**
+ *  Places the framebuffer's top left corner at (x, y) on the display,
+ *  drawing each of its pixels as a scale x scale square. The framebuffer
+ *  must fit on the display. Marks the whole framebuffer dirty.
+ */
+void tft_fbPlace(short x, short y, unsigned char scale) {
+    fb_x = x;
+    fb_y = y;
+    fb_scale = scale ? scale : 1;
+    tft_fbInvalidate();
+}
+
+/**
+ *  Switches to a new palette, and marks the whole framebuffer dirty so the
+ *  next flush shows it.
+ */
+void tft_fbSetPalette(const unsigned short *palette) {
+    fb_palette = palette;
+    last_valid = 0;
+    tft_fbInvalidate();
+}
+
+/**
+ *  Marks the whole framebuffer dirty, e.g. after the display has been
+ *  drawn on directly.
+ */
+void tft_fbInvalidate(void) {
+    short y;
+
+    for (y = 0; y < fb_h; y++) {
+        dirty_x0[y] = 0;
+        dirty_x1[y] = fb_w - 1;
+    }
+}
+
+/**
+ *  Sends drawing to the framebuffer instead of the display, until
+ *  tft_fbEnd(). Both empty the clip stack (see tft_pushClip()).
+ */
+void tft_fbBegin(void) {
+    if (active)
+        return;
+    screen_w = _width;
+    screen_h = _height;
+    _width = fb_w;
+    _height = fb_h;
+    tft_resetClip();
+    _tft_sink = &fb_sink;
+    active = 1;
+}
+
+/**
+ *  Sends drawing back to the display. The framebuffer keeps its contents;
+ *  tft_fbFlush() may still be called.
+ */
+void tft_fbEnd(void) {
+    if (!active)
+        return;
+    _tft_sink = NULL;
+    _width = screen_w;
+    _height = screen_h;
+    tft_resetClip();
+    active = 0;
+}
+
+/**
+ *  Sends the pixels that have changed since the last flush to the display.
+ *  Consecutive rows with the same changed span go out through a single
+ *  address window.
+ */
+void tft_fbFlush(void) {
+    const struct tft_sink *sink = _tft_sink;
+    short y, y1, r, x, x0, x1;
+    unsigned char k;
+    unsigned short *p, c;
+    unsigned long n;
+
+    _tft_sink = NULL;
+    tft_beginWrite();
+    for (y = 0; y < fb_h; y = y1) {
+        x0 = dirty_x0[y];
+        x1 = dirty_x1[y];
+        y1 = y + 1;
+        if (x0 > x1)
+            continue;
+        while ((y1 < fb_h) && (dirty_x0[y1] == x0) && (dirty_x1[y1] == x1))
+            y1++;
+
+        // Not tft_setWindow(): while we are active, its clip rectangle is
+        // the framebuffer's own size, not the display's.
+        tft_screenWindow(fb_x + x0 * fb_scale, fb_y + y * fb_scale,
+                         fb_x + (x1 + 1) * fb_scale - 1,
+                         fb_y + y1 * fb_scale - 1);
+        n = (unsigned long)(x1 - x0 + 1) * fb_scale;
+        for (r = y; r < y1; r++) {
+            p = line_buf;
+            for (x = x0; x <= x1; x++) {
+                c = fb_palette[fb_get(x, r)];
+                for (k = 0; k < fb_scale; k++)
+                    *p++ = c;
+            }
+            for (k = 0; k < fb_scale; k++)
+                tft_pushPixels(line_buf, n);
+            dirty_x0[r] = 0x7FFF;
+            dirty_x1[r] = -1;
+        }
+    }
+    tft_endWrite();
+    _tft_sink = sink;
+}
@@ -0,0 +1,44 @@
+#ifndef TFT_FB_H
+#define TFT_FB_H
+
+/**
+ *  @file   tft_fb.h
+ *
+ *  @brief  An indexed-color (1, 2 or 4 bits per pixel) shadow framebuffer
+ *          for the TFT, flushed to the display as changed spans only.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *          Between tft_fbBegin() and tft_fbEnd(), all drawing functions
+ *          (tft_gfx.h, tft_master.h, tft_band.h, tft_dma.h) draw into the
+ *          framebuffer instead of the display, in framebuffer coordinates:
+ *          tft_width() and tft_height() return its size. Colors are mapped
+ *          to the closest palette entry, and tft_readRect() and
+ *          tft_readPixel() return palette colors from the framebuffer.
+ *          tft_fbFlush() then sends the pixels that changed, expanded
+ *          through the palette.
+ *
+ *          Each row keeps the span of columns written with a new value
+ *          since the last flush, so a frame that redraws everything but
+ *          changes little sends little.
+ *
+ *          A 320x240 framebuffer takes 19200 bytes at 2 bits per pixel; at
+ *          4 bits, use a smaller one (e.g. 160x120, shown at scale 2).
+ *          The hardware scrolling of tft_console.h doesn't mix with it.
+ *
+ *  @author Jeff Lutgen
+ */
+
+// Number of bytes needed for a w x h framebuffer at bpp bits per pixel
+#define TFT_FB_BYTES(w, h, bpp) ((((w) * (bpp) + 7) / 8) * (unsigned long)(h))
+
+void tft_fbInit(unsigned char *buf, short w, short h, unsigned char bpp,
+                const unsigned short *palette);
+void tft_fbPlace(short x, short y, unsigned char scale);
+void tft_fbSetPalette(const unsigned short *palette);
+void tft_fbBegin(void);
+void tft_fbEnd(void);
+void tft_fbFlush(void);
+void tft_fbInvalidate(void);
+
+#endif // TFT_FB_H
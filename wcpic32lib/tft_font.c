@@ -0,0 +1,141 @@
+/*
+ *  @file   tft_font.c
+ *
+ *  @brief  Anti-aliased proportional fonts for the TFT, stored in flash in
+ *          a compact run-length encoded format.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include "tft_font.h"
+#include "tft_master.h"
+#include "private/tft_counters.h"
+
+static unsigned short line_buf[TFT_FONT_MAX_WIDTH];
+
+// Colors for each coverage value, blended from bg (0) to fg (maximum)
+static unsigned short ramp[16];
+static unsigned short ramp_fg, ramp_bg;
+static unsigned char ramp_bpp;      // 0 until the ramp is first computed
+
+// Channel value a/max of the way from c0 to c1, rounded to nearest
+#define BLEND(c0, c1, a, max)   \
+    (((c0) * ((max) - (a)) + (c1) * (a) + (max) / 2) / (max))
+
+static void tft_fontRamp(unsigned char bpp, unsigned short fg,
+                         unsigned short bg) {
+    unsigned char a, max = (1 << bpp) - 1;
+
+    if ((bpp == ramp_bpp) && (fg == ramp_fg) && (bg == ramp_bg))
+        return;
+
+    // Weighted sums of non-negative terms, so the rounding is the same
+    // whether fg is lighter or darker than bg, and a == max gives fg.
+    for (a = 0; a <= max; a++) {
+        ramp[a] = (BLEND(bg >> 11, fg >> 11, a, max) << 11) |
+                  (BLEND((bg >> 5) & 0x3F, (fg >> 5) & 0x3F, a, max) << 5) |
+                   BLEND(bg & 0x1F, fg & 0x1F, a, max);
+    }
+    ramp_fg = fg;
+    ramp_bg = bg;
+    ramp_bpp = bpp;
+}
+
+static const struct tft_glyph *tft_fontGlyph(const struct tft_font *font,
+                                             unsigned char c) {
+    if ((c < font->first) || (c > font->last))
+        return 0;
+    return &font->glyphs[c - font->first];
+}
+
+/*
+ *  Draws glyph g's character cell with its top left corner at (x, y),
+ *  decoding the bitmap a row at a time and sending the visible part of
+ *  each row.
+ */
+static void tft_fontCell(short x, short y, const struct tft_font *font,
+                         const struct tft_glyph *g) {
+    const unsigned char *p = font->data + g->offset;
+    unsigned char mask = (1 << font->bpp) - 1;
+    unsigned char run = 0, value = 0, byte;
+    short i0, i1, j0, j1, r, c, w = g->advance;
+    unsigned short *q;
+
+    i0 = (x < _clip_x0) ? _clip_x0 - x : 0;
+    j0 = (y < _clip_y0) ? _clip_y0 - y : 0;
+    i1 = (x + w - 1 > _clip_x1) ? _clip_x1 - x : w - 1;
+    j1 = (y + font->height - 1 > _clip_y1) ? _clip_y1 - y
+                                           : font->height - 1;
+    if ((i0 > i1) || (j0 > j1))
+        return;
+
+    tft_setWindow(x + i0, y + j0, x + i1, y + j1);
+    for (r = 0; r <= j1; r++) {
+        for (c = 0; c < w; c++)
+            line_buf[c] = ramp[0];
+        if ((r >= g->y_off) && (r < g->y_off + g->height)) {
+            q = line_buf + g->x_off;
+            for (c = 0; c < g->width; c++) {
+                if (run == 0) {
+                    byte = *p++;
+                    run = (byte >> font->bpp) + 1;
+                    value = byte & mask;
+                }
+                run--;
+                *q++ = ramp[value];
+            }
+        }
+        if (r >= j0)
+            tft_pushPixels(line_buf + i0, i1 - i0 + 1);
+    }
+}
+
+/**
+ *  Draws the string `str` in the given font and color, over background
+ *  color `bg`, as a single line with the top left corner of its first
+ *  character cell at (x, y), and returns its width in pixels. The
+ *  baseline is font->ascent pixels below y. Characters the font lacks are
+ *  skipped.
+ *
+ *  Example:
+ *
+ *      extern const struct tft_font dejavu12;
+ *      tft_fontDrawText(4, 4, "Battery 87%", &dejavu12,
+ *                       ILI9340_WHITE, ILI9340_BLACK);
+ */
+short tft_fontDrawText(short x, short y, const char *str,
+                       const struct tft_font *font,
+                       unsigned short color, unsigned short bg) {
+    const struct tft_glyph *g;
+    short x0 = x;
+
+    TFT_STAT_PRIM(TEXT);
+    tft_fontRamp(font->bpp, color, bg);
+    tft_beginWrite();
+    for (; *str; str++) {
+        g = tft_fontGlyph(font, *str);
+        if (!g)
+            continue;
+        tft_fontCell(x, y, font, g);
+        x += g->advance;
+    }
+    tft_endWrite();
+    return x - x0;
+}
+
+/**
+ *  Returns the width in pixels of the string `str` in the given font.
+ */
+short tft_fontTextWidth(const char *str, const struct tft_font *font) {
+    const struct tft_glyph *g;
+    short w = 0;
+
+    for (; *str; str++) {
+        g = tft_fontGlyph(font, *str);
+        if (g)
+            w += g->advance;
+    }
+    return w;
+}
@@ -0,0 +1,54 @@
+#ifndef TFT_FONT_H
+#define TFT_FONT_H
+
+/**
+ *  @file   tft_font.h
+ *
+ *  @brief  Anti-aliased proportional fonts for the TFT, stored in flash in
+ *          a compact run-length encoded format.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *          Fonts are generated from TTF or BDF files with
+ *          tools/fontconv.py, which writes a .c file defining a
+ *          `const struct tft_font`; declare it in your code with
+ *          `extern const struct tft_font name;`.
+ *
+ *          Each glyph is a 2 or 4 bits per pixel coverage (alpha) bitmap.
+ *          Text is drawn over a known background color, blending through a
+ *          precomputed ramp of 5-6-5 colors, and each character goes out
+ *          as one address window.
+ *
+ *  @author Jeff Lutgen
+ */
+
+// Widest character cell (advance) supported, in pixels
+#define TFT_FONT_MAX_WIDTH  64
+
+struct tft_glyph {
+    unsigned short offset;      // start of the glyph's data in `data`
+    unsigned char width;        // size of the bitmap
+    unsigned char height;
+    unsigned char x_off;        // bitmap position within the character cell
+    unsigned char y_off;
+    unsigned char advance;      // cell width: distance to the next character
+};
+
+struct tft_font {
+    unsigned char bpp;          // 2 or 4
+    unsigned char first;        // first and last character in the font
+    unsigned char last;
+    unsigned char height;       // line height (cell height)
+    unsigned char ascent;       // distance from top of cell to baseline
+    const struct tft_glyph *glyphs;
+    // Bitmaps, row by row, as runs: each byte holds a count minus one in
+    // its upper 8 - bpp bits and a coverage value in its lower bpp bits.
+    const unsigned char *data;
+};
+
+short tft_fontDrawText(short x, short y, const char *str,
+                       const struct tft_font *font,
+                       unsigned short color, unsigned short bg);
+short tft_fontTextWidth(const char *str, const struct tft_font *font);
+
+#endif // TFT_FONT_H
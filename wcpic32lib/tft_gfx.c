@@ -54,12 +54,29 @@
 #include "tft_gfx.h"
 #include "private/glcdfont.h"
 #include "tft_master.h"
+#include "private/tft_counters.h"
+#include "private/tft_edge.h"
 
 #define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+
+// Bit i of a bitmap row (most significant bit first)
+#define bitmap_bit(row, i) (pgm_read_byte((row) + ((i) >> 3)) & (128 >> ((i) & 7)))
+
 #define swap(a, b) { short t = a; a = b; b = t; }
 
 unsigned short cursor_y, cursor_x, textsize, textcolor, textbgcolor, wrap;
 
+// One row of pixels on their way to the display (320 = longer screen side)
+static unsigned short line_buf[320];
+
+// Cache of expanded glyph rows for tft_drawChar(), see tft_glyphRow()
+#define GLYPH_CACHE_SLOTS       16
+#define GLYPH_CACHE_MAX_SIZE    4
+static unsigned short cache_rows[GLYPH_CACHE_SLOTS][6 * GLYPH_CACHE_MAX_SIZE];
+static signed char cache_tags[GLYPH_CACHE_SLOTS];
+static unsigned short cache_fg, cache_bg;
+static unsigned char cache_size;    // 0 until the cache is first filled
+
 static void tft_drawCircleHelper(short x0, short y0, short r,
                                  unsigned char cornername,
                                  unsigned short color);
@@ -67,23 +84,54 @@ static void tft_fillCircleHelper(short x0, short y0, short r,
                                  unsigned char cornername,
                                  short delta, unsigned short color);
 
-/**
- *  Draws a circle with center (x0,y0) and radius r in the given color.
+/*
+ *  Draws the points (x0 +/- x, y0 +/- y) and (x0 +/- y, y0 +/- x) for
+ *  x = xs..xe, in the quadrants selected by `corners` (see
+ *  tft_drawCircleHelper()): a horizontal and a vertical span per quadrant.
  */
-void tft_drawCircle(short x0, short y0, short r, unsigned short color) {
+static void tft_circleRun(short x0, short y0, short xs, short xe, short y,
+                          unsigned char corners, unsigned short color) {
+    short n = xe - xs + 1;
+
+    if (corners & 0x4) {
+        tft_drawFastHLine(x0 + xs, y0 + y, n, color);
+        tft_drawFastVLine(x0 + y, y0 + xs, n, color);
+    }
+    if (corners & 0x2) {
+        tft_drawFastHLine(x0 + xs, y0 - y, n, color);
+        tft_drawFastVLine(x0 + y, y0 - xe, n, color);
+    }
+    if (corners & 0x8) {
+        tft_drawFastVLine(x0 - y, y0 + xs, n, color);
+        tft_drawFastHLine(x0 - xe, y0 + y, n, color);
+    }
+    if (corners & 0x1) {
+        tft_drawFastVLine(x0 - y, y0 - xe, n, color);
+        tft_drawFastHLine(x0 - xe, y0 - y, n, color);
+    }
+}
+
+/*
+ *  Midpoint circle, drawing the same pixels as plotting each step would,
+ *  but merging the steps along which y stays put into one span. `first`
+ *  is 0 to include the points on the axes, or 1 to leave them out.
+ */
+static void tft_circleSpans(short x0, short y0, short r, unsigned char corners,
+                            short first, unsigned short color) {
     short f = 1 - r;
     short ddF_x = 1;
     short ddF_y = -2 * r;
     short x = 0;
     short y = r;
+    short xs = first;   // where the current span started
 
-    tft_drawPixel(x0  , y0+r, color);
-    tft_drawPixel(x0  , y0-r, color);
-    tft_drawPixel(x0+r, y0  , color);
-    tft_drawPixel(x0-r, y0  , color);
-
+    tft_beginWrite();
     while (x < y) {
         if (f >= 0) {
+            // y changes with the next step, so the span ends here
+            if (xs <= x)
+                tft_circleRun(x0, y0, xs, x, y, corners, color);
+            xs = x + 1;
             y--;
             ddF_y += 2;
             f += ddF_y;
@@ -91,58 +139,32 @@ void tft_drawCircle(short x0, short y0, short r, unsigned short color) {
         x++;
         ddF_x += 2;
         f += ddF_x;
-
-        tft_drawPixel(x0 + x, y0 + y, color);
-        tft_drawPixel(x0 - x, y0 + y, color);
-        tft_drawPixel(x0 + x, y0 - y, color);
-        tft_drawPixel(x0 - x, y0 - y, color);
-        tft_drawPixel(x0 + y, y0 + x, color);
-        tft_drawPixel(x0 - y, y0 + x, color);
-        tft_drawPixel(x0 + y, y0 - x, color);
-        tft_drawPixel(x0 - y, y0 - x, color);
     }
+    if (xs <= x)
+        tft_circleRun(x0, y0, xs, x, y, corners, color);
+    tft_endWrite();
+}
+
+/**
+ *  Draws a circle with center (x0,y0) and radius r in the given color.
+ */
+void tft_drawCircle(short x0, short y0, short r, unsigned short color) {
+    TFT_STAT_PRIM(CIRCLE);
+
+    tft_circleSpans(x0, y0, r, 0xF, 0, color);
 }
 
 static void tft_drawCircleHelper( short x0, short y0,
         short r, unsigned char cornername, unsigned short color) {
     // Helper function for drawing circles and circular objects
-    short f     = 1 - r;
-    short ddF_x = 1;
-    short ddF_y = -2 * r;
-    short x     = 0;
-    short y     = r;
-
-    while (x < y) {
-        if (f >= 0) {
-            y--;
-            ddF_y += 2;
-            f     += ddF_y;
-        }
-        x++;
-        ddF_x += 2;
-        f     += ddF_x;
-        if (cornername & 0x4) {
-            tft_drawPixel(x0 + x, y0 + y, color);
-            tft_drawPixel(x0 + y, y0 + x, color);
-        }
-        if (cornername & 0x2) {
-            tft_drawPixel(x0 + x, y0 - y, color);
-            tft_drawPixel(x0 + y, y0 - x, color);
-        }
-        if (cornername & 0x8) {
-            tft_drawPixel(x0 - y, y0 + x, color);
-            tft_drawPixel(x0 - x, y0 + y, color);
-        }
-        if (cornername & 0x1) {
-            tft_drawPixel(x0 - y, y0 - x, color);
-            tft_drawPixel(x0 - x, y0 - y, color);
-        }
-    }
+    tft_circleSpans(x0, y0, r, cornername, 1, color);
 }
 /**
  *  Draws a filled circle with center (x0,y0) and radius r in the given color.
  */
 void tft_fillCircle(short x0, short y0, short r, unsigned short color) {
+    TFT_STAT_PRIM(FILLCIRCLE);
+
     tft_drawFastVLine(x0, y0-r, 2*r+1, color);
     tft_fillCircleHelper(x0, y0, r, 3, 0, color);
 }
@@ -179,6 +201,10 @@ static void tft_fillCircleHelper(short x0, short y0, short r,
 
 /**
  * Draws a straight line from (x0,y0) to (x1,y1) in the given color.
+ *
+ * The line is clipped to the clip rectangle before it is rasterized, and each run
+ * of pixels along the major axis goes out as one horizontal or vertical
+ * span. The pixels drawn are exactly those of the classic Bresenham loop.
  */
 void tft_drawLine(short x0, short y0,
         short x1, short y1,
@@ -186,9 +212,23 @@ void tft_drawLine(short x0, short y0,
 
     // Bresenham's algorithm - thx wikpedia
     short steep = abs(y1 - y0) > abs(x1 - x0);
+    short dx, dy, err, ystep, xs, xe;
+    short mj0, mj1, mn0, mn1;   // clip rectangle along each axis
+    long long lo, hi, a, b, m;
+    TFT_STAT_PRIM(LINE);
+
     if (steep) {
         swap(x0, y0);
         swap(x1, y1);
+        mj0 = _clip_y0;
+        mj1 = _clip_y1;
+        mn0 = _clip_x0;
+        mn1 = _clip_x1;
+    } else {
+        mj0 = _clip_x0;
+        mj1 = _clip_x1;
+        mn0 = _clip_y0;
+        mn1 = _clip_y1;
     }
 
     if (x0 > x1) {
@@ -196,31 +236,68 @@ void tft_drawLine(short x0, short y0,
         swap(y0, y1);
     }
 
-    short dx, dy;
     dx = x1 - x0;
     dy = abs(y1 - y0);
+    ystep = (y0 < y1) ? 1 : -1;
 
-    short err = dx / 2;
-    short ystep;
+    if (dx == 0) {
+        tft_drawPixel(steep ? y0 : x0, steep ? x0 : y0, color);
+        return;
+    }
 
-    if (y0 < y1) {
-        ystep = 1;
+    // After k steps the loop below has moved m(k) = (k*dy - dx/2 + dx - 1)
+    // / dx times along the minor axis. Find the steps [lo, hi] that stay
+    // inside the clip rectangle along both axes.
+    lo = (x0 < mj0) ? mj0 - x0 : 0;
+    hi = (x1 > mj1) ? mj1 - x0 : dx;
+    if (ystep > 0) {
+        a = mn0 - y0;           // m must be at least a ...
+        b = mn1 - y0;           // ... and at most b
     } else {
-        ystep = -1;
+        a = y0 - mn1;
+        b = y0 - mn0;
     }
+    if (b < 0)
+        return;
+    if (a > 0) {
+        if (dy == 0)
+            return;
+        m = ((a - 1) * dx + dx / 2) / dy + 1;  // first k with m(k) >= a
+        if (m > lo)
+            lo = m;
+    }
+    if (dy != 0) {
+        m = (b * dx + dx / 2) / dy;            // last k with m(k) <= b
+        if (m < hi)
+            hi = m;
+    }
+    if (lo > hi)
+        return;
 
-    for (; x0 <= x1; x0++) {
-        if (steep) {
-            tft_drawPixel(y0, x0, color);
-        } else {
-            tft_drawPixel(x0, y0, color);
-        }
+    // Jump to step lo
+    m = (lo * dy - dx / 2 + dx - 1) / dx;
+    err = dx / 2 - lo * dy + m * dx;
+    y0 += ystep * m;
+    xs = x0 + lo;
+    xe = x0 + hi;
+
+    tft_beginWrite();
+    for (x0 = xs; ; x0++) {
         err -= dy;
-        if (err < 0) {
+        if ((err < 0) || (x0 == xe)) {
+            // the run along the major axis ends here
+            if (steep)
+                tft_drawFastVLine(y0, xs, x0 - xs + 1, color);
+            else
+                tft_drawFastHLine(xs, y0, x0 - xs + 1, color);
+            if (x0 == xe)
+                break;
             y0 += ystep;
             err += dx;
+            xs = x0 + 1;
         }
     }
+    tft_endWrite();
 }
 
 /**
@@ -228,6 +305,8 @@ void tft_drawLine(short x0, short y0,
  *  height h with given color.
  */
 void tft_drawRect(short x, short y, short w, short h, unsigned short color) {
+    TFT_STAT_PRIM(RECT);
+
     tft_drawFastHLine(x, y, w, color);
     tft_drawFastHLine(x, y+h-1, w, color);
     tft_drawFastVLine(x, y, h, color);
@@ -240,6 +319,8 @@ void tft_drawRect(short x, short y, short w, short h, unsigned short color) {
  */
 void tft_drawRoundRect(short x, short y, short w, short h,
         short r, unsigned short color) {
+    TFT_STAT_PRIM(ROUNDRECT);
+
     // smarter version
     tft_drawFastHLine(x+r  , y    , w-2*r, color); // Top
     tft_drawFastHLine(x+r  , y+h-1, w-2*r, color); // Bottom
@@ -258,6 +339,8 @@ void tft_drawRoundRect(short x, short y, short w, short h,
  */
 void tft_fillRoundRect(short x, short y, short w,
                        short h, short r, unsigned short color) {
+    TFT_STAT_PRIM(FILLROUNDRECT);
+
     // smarter version
     tft_fillRect(x+r, y, w-2*r, h, color);
 
@@ -273,6 +356,8 @@ void tft_fillRoundRect(short x, short y, short w,
 void tft_drawTriangle(short x0, short y0,
                       short x1, short y1,
                       short x2, short y2, unsigned short color) {
+    TFT_STAT_PRIM(TRIANGLE);
+
     tft_drawLine(x0, y0, x1, y1, color);
     tft_drawLine(x1, y1, x2, y2, color);
     tft_drawLine(x2, y2, x0, y0, color);
@@ -281,12 +366,22 @@ void tft_drawTriangle(short x0, short y0,
 /**
  *  Draws a filled triangle with vertices (x0,y0), (x1,y1), (x2,y2) in the
  *  given color
+ *
+ *  Pixel (x, y) is filled when the point (x, y) is inside the triangle;
+ *  points on a left or top edge count as inside and points on a right or
+ *  bottom edge don't (the top-left rule), so triangles that share an edge
+ *  neither overlap nor leave a gap, and a triangle with no area draws
+ *  nothing. Edges are stepped exactly, without a division per scanline,
+ *  and each scanline goes out as one span.
  */
 void tft_fillTriangle (short x0, short y0,
                        short x1, short y1,
                        short x2, short y2,
                        unsigned short color) {
-    short a, b, y, last;
+    struct tft_edge e02, es, *left, *right;
+    short y, yend;
+    long long side;
+    TFT_STAT_PRIM(FILLTRIANGLE);
 
     // Sort coordinates by Y order (y2 >= y1 >= y0)
     if (y0 > y1) {
@@ -299,86 +394,108 @@ void tft_fillTriangle (short x0, short y0,
         swap(y0, y1); swap(x0, x1);
     }
 
-    if(y0 == y2) { // Handle awkward all-on-same-line case as its own thing
-        a = b = x0;
-        if(x1 < a)      a = x1;
-        else if(x1 > b) b = x1;
-        if(x2 < a)      a = x2;
-        else if(x2 > b) b = x2;
-        tft_drawFastHLine(a, y0, b-a+1, color);
+    // Which side of the long edge (0-2) is vertex 1 on?
+    side = (long long)(x1 - x0) * (y2 - y0) - (long long)(y1 - y0) * (x2 - x0);
+    if (side == 0)
         return;
+    if (side > 0) {
+        left = &e02;
+        right = &es;
+    } else {
+        left = &es;
+        right = &e02;
     }
 
-    short
-        dx01 = x1 - x0,
-        dy01 = y1 - y0,
-        dx02 = x2 - x0,
-        dy02 = y2 - y0,
-        dx12 = x2 - x1,
-        dy12 = y2 - y1,
-        sa   = 0,
-        sb   = 0;
-
-    // For upper part of triangle, find scanline crossings for segments
-    // 0-1 and 0-2.  If y1=y2 (flat-bottomed triangle), the scanline y1
-    // is included here (and second loop will be skipped, avoiding a /0
-    // error there), otherwise scanline y1 is skipped here and handled
-    // in the second loop...which also avoids a /0 error here if y0=y1
-    // (flat-topped triangle).
-    if (y1 == y2)
-        last = y1;   // Include y1 scanline
+    y = (y0 < _clip_y0) ? _clip_y0 : y0;
+    yend = (y2 - 1 > _clip_y1) ? _clip_y1 : y2 - 1;
+    if (y > yend)
+        return;
+    tft_edgeStart(&e02, x0, y0, x2, y2, y);
+    if (y < y1)
+        tft_edgeStart(&es, x0, y0, x1, y1, y);
     else
-        last = y1-1; // Skip it
-
-    for (y=y0; y<=last; y++) {
-        a   = x0 + sa / dy01;
-        b   = x0 + sb / dy02;
-        sa += dx01;
-        sb += dx02;
-        /* longhand:
-           a = x0 + (x1 - x0) * (y - y0) / (y1 - y0);
-           b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
-           */
-        if (a > b)
-            swap(a,b);
-        tft_drawFastHLine(a, y, b-a+1, color);
-    }
-
-    // For lower part of triangle, find scanline crossings for segments
-    // 0-2 and 1-2.  This loop is skipped if y1=y2.
-    sa = dx12 * (y - y1);
-    sb = dx02 * (y - y0);
-    for (; y<=y2; y++) {
-        a   = x1 + sa / dy12;
-        b   = x0 + sb / dy02;
-        sa += dx12;
-        sb += dx02;
-        /* longhand:
-           a = x1 + (x2 - x1) * (y - y1) / (y2 - y1);
-           b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
-           */
-        if(a > b) swap(a,b);
-        tft_drawFastHLine(a, y, b-a+1, color);
+        tft_edgeStart(&es, x1, y1, x2, y2, y);
+
+    tft_beginWrite();
+    for (; y <= yend; y++) {
+        if ((y == y1) && (y != y0))
+            tft_edgeStart(&es, x1, y1, x2, y2, y);
+        if (right->x > left->x)
+            tft_drawFastHLine(left->x, y, right->x - left->x, color);
+        tft_edgeStep(&e02);
+        tft_edgeStep(&es);
     }
+    tft_endWrite();
 }
 
 /**
  *  Draws the given bitmap at position (x, y) using the
  *  given color. The width w and height h of the bitmap must also be provided.
+ *
+ *  Only the set bits are drawn; see tft_drawBitmap2() for opaque bitmaps.
  */
 void tft_drawBitmap(short x, short y,
         const unsigned char *bitmap, short w, short h,
         unsigned short color) {
+    tft_drawBitmap2(x, y, bitmap, w, h, color, color);
+}
 
-    short i, j, byteWidth = (w + 7) / 8;
+/**
+ *  Draws the w x h bitmap `bitmap` (1 bit per pixel, most significant bit
+ *  first, each row starting on a new byte) at position (x, y), with set
+ *  bits in color `color` and clear bits in color `bg`. If `bg` is the same
+ *  as `color`, clear bits are left alone (transparent background).
+ *
+ *  An opaque bitmap is sent through a single address window; a transparent
+ *  one as one span per run of set bits in each row.
+ *
+ *  Example:
+ *
+ *      static const unsigned char icon[] = { ... };   // 32 x 32
+ *      tft_drawBitmap2(10, 10, icon, 32, 32, ILI9340_WHITE, ILI9340_BLUE);
+ */
+void tft_drawBitmap2(short x, short y, const unsigned char *bitmap,
+                     short w, short h, unsigned short color,
+                     unsigned short bg) {
+    short i, j, run, byteWidth = (w + 7) / 8;
+    short i0, i1, j0, j1;   // visible columns and rows of the bitmap
+    const unsigned char *row;
+    unsigned short *p;
+    TFT_STAT_PRIM(BITMAP);
+
+    i0 = (x < _clip_x0) ? _clip_x0 - x : 0;
+    j0 = (y < _clip_y0) ? _clip_y0 - y : 0;
+    i1 = (x + w - 1 > _clip_x1) ? _clip_x1 - x : w - 1;
+    j1 = (y + h - 1 > _clip_y1) ? _clip_y1 - y : h - 1;
+    if ((i0 > i1) || (j0 > j1))
+        return;
 
-    for (j = 0; j < h; j++) {
-        for(i = 0; i < w; i++ ) {
-            if(pgm_read_byte(bitmap + j * byteWidth + i / 8) & (128 >> (i & 7))) {
-                tft_drawPixel(x+i, y+j, color);
+    tft_beginWrite();
+    if (bg != color)
+        tft_setWindow(x + i0, y + j0, x + i1, y + j1);
+    for (j = j0; j <= j1; j++) {
+        row = bitmap + j * byteWidth;
+        if (bg != color) {
+            p = line_buf;
+            for (i = i0; i <= i1; i++)
+                *p++ = bitmap_bit(row, i) ? color : bg;
+            tft_pushPixels(line_buf, i1 - i0 + 1);
+            continue;
+        }
+        for (i = i0; i <= i1; ) {
+            if (((i & 7) == 0) && (pgm_read_byte(row + (i >> 3)) == 0)) {
+                i += 8;     // skip blank bytes whole
+                continue;
+            }
+            if (!bitmap_bit(row, i)) {
+                i++;
+                continue;
             }
+            for (run = i; (i <= i1) && bitmap_bit(row, i); i++) { ; }
+            tft_drawFastHLine(x + run, y + j, i - run, color);
         }
     }
+    tft_endWrite();
 }
 
 /**
@@ -419,43 +536,197 @@ inline void tft_writeString(char* str){
     }
 }
 
+/*
+ *  Returns pixel columns c0 to c1 of one row of a glyph, `size` times
+ *  wider: glyph column i (0 to 5) is `color` if bit i of `bits` is set,
+ *  and `bg` otherwise.
+ *
+ *  For sizes up to GLYPH_CACHE_MAX_SIZE the expanded rows are kept in a
+ *  small direct-mapped cache, which is emptied whenever the colors or the
+ *  size change. Numeric readouts use few distinct rows, so most hit.
+ *  Larger sizes expand just columns c0 to c1 into line_buf, since a whole
+ *  row may not fit; they must be visible columns.
+ */
+static const unsigned short *tft_glyphRow(unsigned char bits,
+                                          unsigned short color,
+                                          unsigned short bg,
+                                          unsigned char size,
+                                          short c0, short c1) {
+    unsigned short *p, *row, c;
+    unsigned char i, k, slot;
+
+    if (size > GLYPH_CACHE_MAX_SIZE) {
+        p = line_buf;
+        i = c0 / size;
+        k = c0 - i * size;
+        for (; c0 <= c1; c0++) {
+            *p++ = (bits & (1 << i)) ? color : bg;
+            if (++k == size) {
+                k = 0;
+                i++;
+            }
+        }
+        return line_buf;
+    }
+
+    if ((color != cache_fg) || (bg != cache_bg) || (size != cache_size)) {
+        for (slot = 0; slot < GLYPH_CACHE_SLOTS; slot++)
+            cache_tags[slot] = -1;
+        cache_fg = color;
+        cache_bg = bg;
+        cache_size = size;
+    }
+    slot = bits & (GLYPH_CACHE_SLOTS - 1);
+    row = cache_rows[slot];
+    if (cache_tags[slot] == bits)
+        return row + c0;
+    cache_tags[slot] = bits;
+
+    p = row;
+    for (i = 0; i < 6; i++) {
+        c = (bits & (1 << i)) ? color : bg;
+        for (k = 0; k < size; k++)
+            *p++ = c;
+    }
+    return row + c0;
+}
+
 /**
  *  Prints the character c at position (x, y) using the given foreground
  *  color `color` and background color `bg`, of the given size
  *  (1 is smallest)
+ *
+ *  With an opaque background (bg != color) the character goes out as one
+ *  address window and a single pixel burst; with a transparent one, as a
+ *  rectangle per run of set pixels in each row.
  */
 void tft_drawChar(short x, short y, unsigned char c, unsigned short color,
                   unsigned short bg, unsigned char size) {
-    char i, j;
-    if((x >= _width)            || // Clip right
-       (y >= _height)           || // Clip bottom
-       ((x + 6 * size - 1) < 0) || // Clip left
-       ((y + 8 * size - 1) < 0))   // Clip top
+    unsigned char i, j, bits, run;
+    short py, i0, i1, j0, j1;
+    const unsigned char *glyph = font + c * 5;
+    const unsigned short *row;
+    TFT_STAT_PRIM(CHAR);
+
+    if((x > _clip_x1)                   || // Clip right
+       (y > _clip_y1)                   || // Clip bottom
+       ((x + 6 * size - 1) < _clip_x0)  || // Clip left
+       ((y + 8 * size - 1) < _clip_y0)  || // Clip top
+       (size == 0))
         return;
 
-    for (i = 0; i < 6; i++ ) {
-        unsigned char line;
-        if (i == 5)
-            line = 0x0;
-        else
-            line = pgm_read_byte(font+(c*5)+i);
+    tft_beginWrite();
+    if (bg == color) {
         for (j = 0; j < 8; j++) {
-            if (line & 0x1) {
-                if (size == 1) // default size
-                    tft_drawPixel(x+i, y+j, color);
-                else {  // big size
-                    tft_fillRect(x+(i*size), y+(j*size), size, size, color);
-                }
-            } else if (bg != color) {
-                if (size == 1) // default size
-                    tft_drawPixel(x+i, y+j, bg);
-                else {  // big size
-                    tft_fillRect(x+i*size, y+j*size, size, size, bg);
+            for (i = 0; i < 5; ) {
+                if (!(pgm_read_byte(glyph + i) & (1 << j))) {
+                    i++;
+                    continue;
                 }
+                for (run = i; (i < 5) && (pgm_read_byte(glyph + i) & (1 << j));
+                     i++) { ; }
+                tft_fillRect(x + run * size, y + j * size, (i - run) * size,
+                             size, color);
+            }
+        }
+        tft_endWrite();
+        return;
+    }
+
+    // Visible pixel columns and rows of the character cell
+    i0 = (x < _clip_x0) ? _clip_x0 - x : 0;
+    j0 = (y < _clip_y0) ? _clip_y0 - y : 0;
+    i1 = (x + 6 * size - 1 > _clip_x1) ? _clip_x1 - x : 6 * size - 1;
+    j1 = (y + 8 * size - 1 > _clip_y1) ? _clip_y1 - y : 8 * size - 1;
+
+    tft_setWindow(x + i0, y + j0, x + i1, y + j1);
+    for (py = j0; py <= j1; ) {
+        j = py / size;
+        bits = 0;
+        for (i = 0; i < 5; i++) {
+            if (pgm_read_byte(glyph + i) & (1 << j))
+                bits |= 1 << i;
+        }
+        // send this glyph row once for each pixel row it covers
+        row = tft_glyphRow(bits, color, bg, size, i0, i1);
+        do {
+            tft_pushPixels(row, i1 - i0 + 1);
+        } while ((++py <= j1) && (py % size != 0));
+    }
+    tft_endWrite();
+}
+
+/**
+ *  Draws the string `str` as a single line of text with its top left
+ *  corner at (x, y), using the given colors and size as tft_drawChar()
+ *  does, and returns its width in pixels (at most 32767). There is no
+ *  wrapping, and control characters are drawn as glyphs like any others.
+ *
+ *  With an opaque background (bg != color) the whole line goes out
+ *  through one address window, streamed a pixel row at a time, so it is
+ *  much faster than printing the characters one by one.
+ *
+ *  Example:
+ *
+ *      // right-align a reading against x = 200
+ *      char buf[12];
+ *      sprintf(buf, "%5d rpm", rpm);
+ *      tft_drawText(200 - 6 * 2 * strlen(buf), 40, buf,
+ *                   ILI9340_YELLOW, ILI9340_BLACK, 2);
+ */
+short tft_drawText(short x, short y, const char *str, unsigned short color,
+                   unsigned short bg, unsigned char size) {
+    long n, k, w, i0, i1, c0, c1;   // long: a line can be far wider than 0x7FFF
+    short py, j0, j1, width;
+    unsigned char i, j, bits;
+    const unsigned char *glyph;
+    const unsigned short *row;
+    TFT_STAT_PRIM(TEXT);
+
+    for (n = 0; str[n]; n++) { ; }
+    if (size == 0)
+        return 0;
+    w = 6 * size;
+    width = (n * w > 0x7FFF) ? 0x7FFF : n * w;
+
+    if (bg == color) {
+        tft_beginWrite();
+        for (k = 0; (k < n) && (x + k * w <= _clip_x1); k++) {
+            if (x + (k + 1) * w > _clip_x0)
+                tft_drawChar(x + k * w, y, str[k], color, bg, size);
+        }
+        tft_endWrite();
+        return width;
+    }
+
+    // Visible pixel columns and rows of the line
+    i0 = (x < _clip_x0) ? _clip_x0 - x : 0;
+    j0 = (y < _clip_y0) ? _clip_y0 - y : 0;
+    i1 = (x + n * w - 1 > _clip_x1) ? _clip_x1 - x : n * w - 1;
+    j1 = (y + 8 * size - 1 > _clip_y1) ? _clip_y1 - y : 8 * size - 1;
+    if ((i0 > i1) || (j0 > j1))
+        return width;
+
+    tft_beginWrite();
+    tft_setWindow(x + i0, y + j0, x + i1, y + j1);
+    for (py = j0; py <= j1; py++) {
+        j = py / size;
+        for (k = i0 / w; k <= i1 / w; k++) {
+            glyph = font + (unsigned char)str[k] * 5;
+            bits = 0;
+            for (i = 0; i < 5; i++) {
+                if (pgm_read_byte(glyph + i) & (1 << j))
+                    bits |= 1 << i;
             }
-            line >>= 1;
+            // the part of this character's row that's on screen
+            c0 = (k * w < i0) ? i0 - k * w : 0;
+            c1 = ((k + 1) * w - 1 > i1) ? i1 - k * w : w - 1;
+            row = tft_glyphRow(bits, color, bg, size, c0, c1);
+            tft_pushPixels(row, c1 - c0 + 1);
         }
     }
+    tft_endWrite();
+    return width;
 }
 
 /**
@@ -75,8 +75,13 @@ void tft_fillRoundRect(short x0, short y0, short w, short h, short radius,
                        unsigned short color);
 void tft_drawBitmap(short x, short y, const unsigned char *bitmap, short w,
                     short h, unsigned short color);
+void tft_drawBitmap2(short x, short y, const unsigned char *bitmap,
+                     short w, short h, unsigned short color,
+                     unsigned short bg);
 void tft_drawChar(short x, short y, unsigned char c, unsigned short color,
                   unsigned short bg, unsigned char size);
+short tft_drawText(short x, short y, const char *str, unsigned short color,
+                   unsigned short bg, unsigned char size);
 void tft_setCursor(short x, short y);
 void tft_setTextColor(unsigned short c);
 void tft_setTextColor2(unsigned short c, unsigned short bg);
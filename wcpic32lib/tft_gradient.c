@@ -0,0 +1,289 @@
+/*
+ *  @file   tft_gradient.c
+ *
+ *  @brief  Gradient and dithered rectangle fills for the TFT.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include "tft_gradient.h"
+#include "tft_master.h"
+#include "private/tft_counters.h"
+
+// Ramp entries: enough for the diagonal of a 320x240 screen
+#define RAMP_MAX    402
+#define ROW_MAX     320
+
+// Colors are worked on as 5-6-5 with four extra bits of fraction per
+// channel, in 10-bit fields (red at bit 20, green at 10, blue at 0), so
+// that a dither threshold of 0..15 can be added to all three at once.
+#define FIELDS(t)   ((unsigned long)(t) * 0x100401)
+#define ROUND       FIELDS(8)
+
+static unsigned long ramp[RAMP_MAX];
+static unsigned short rows[4][ROW_MAX];
+
+static const unsigned char bayer[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 }
+};
+
+static unsigned long tft_gradExpand(unsigned short c) {
+    return ((unsigned long)(c >> 11) << 24) |
+           ((unsigned long)((c >> 5) & 0x3F) << 14) |
+           ((unsigned long)(c & 0x1F) << 4);
+}
+
+// Drops the fraction bits (after a threshold has been added)
+static inline unsigned short tft_gradPack(unsigned long v) {
+    return ((v >> 13) & 0xF800) | ((v >> 9) & 0x07E0) | ((v >> 4) & 0x001F);
+}
+
+static inline unsigned long tft_gradThreshold(short x, short y,
+                                              unsigned char dither) {
+    return dither ? FIELDS(bayer[y & 3][x & 3]) : ROUND;
+}
+
+/*
+ *  Fills ramp[0..n-1] with the colors k0, k0 + 1, ... steps along a
+ *  gradient that goes from c0 to c1 in `den` steps and stays at c1 after.
+ */
+static void tft_gradRamp(unsigned short c0, unsigned short c1, long k0,
+                         short n, long den) {
+    unsigned long e0 = tft_gradExpand(c0), e1 = tft_gradExpand(c1);
+    long r0 = e0 >> 20, g0 = (e0 >> 10) & 0x3FF, b0 = e0 & 0x3FF;
+    long dr = (long)(e1 >> 20) - r0, dg = (long)((e1 >> 10) & 0x3FF) - g0,
+         db = (long)(e1 & 0x3FF) - b0;
+    long k;
+    short i;
+
+    if (den < 1)
+        den = 1;
+    for (i = 0; i < n; i++) {
+        k = k0 + i;
+        if (k >= den)
+            ramp[i] = e1;
+        else
+            ramp[i] = ((unsigned long)(r0 + dr * k / den) << 20) |
+                      ((unsigned long)(g0 + dg * k / den) << 10) |
+                       (unsigned long)(b0 + db * k / den);
+    }
+}
+
+// Finds the visible part of the w x h rectangle at (x, y), as offsets
+// into it. Returns 0 if none of it is visible.
+static int tft_gradClip(short x, short y, short w, short h, short *i0,
+                        short *j0, short *i1, short *j1) {
+    if ((w <= 0) || (h <= 0))
+        return 0;
+    *i0 = (x < _clip_x0) ? _clip_x0 - x : 0;
+    *j0 = (y < _clip_y0) ? _clip_y0 - y : 0;
+    *i1 = (x + w - 1 > _clip_x1) ? _clip_x1 - x : w - 1;
+    *j1 = (y + h - 1 > _clip_y1) ? _clip_y1 - y : h - 1;
+    return (*i0 <= *i1) && (*j0 <= *j1);
+}
+
+static unsigned long tft_gradSqrt(unsigned long v) {
+    unsigned long r = 0, bit = 1UL << 30;
+
+    while (bit > v)
+        bit >>= 2;
+    for (; bit; bit >>= 2) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+    }
+    return r;
+}
+
+/**
+ *  Fills the rectangle with top-left vertex (x, y), width w and height h
+ *  with a gradient running from color c0 at the left edge to c1 at the
+ *  right edge, dithered if `dither` is nonzero.
+ *
+ *  Example:
+ *
+ *      // title bar shading from navy to blue
+ *      tft_fillGradientH(0, 0, tft_width(), 20, 0x0010, ILI9340_BLUE, 1);
+ */
+void tft_fillGradientH(short x, short y, short w, short h, unsigned short c0,
+                       unsigned short c1, unsigned char dither) {
+    short i, j, i0, j0, i1, j1, n, k, nrows;
+    TFT_STAT_PRIM(GRADIENT);
+
+    if (!tft_gradClip(x, y, w, h, &i0, &j0, &i1, &j1))
+        return;
+
+    // Every row is the same, or one of four when dithering
+    n = i1 - i0 + 1;
+    tft_gradRamp(c0, c1, i0, n, w - 1);
+    nrows = dither ? 4 : 1;
+    for (k = 0; k < nrows; k++) {
+        for (i = 0; i < n; i++)
+            rows[k][i] = tft_gradPack(ramp[i] +
+                tft_gradThreshold(x + i0 + i, y + j0 + k, dither));
+    }
+
+    tft_beginWrite();
+    tft_setWindow(x + i0, y + j0, x + i1, y + j1);
+    for (j = 0; j <= j1 - j0; j++)
+        tft_pushPixels(rows[j & (nrows - 1)], n);
+    tft_endWrite();
+}
+
+/**
+ *  Fills the rectangle with top-left vertex (x, y), width w and height h
+ *  with a gradient running from color c0 at the top edge to c1 at the
+ *  bottom edge, dithered if `dither` is nonzero.
+ *
+ *  Example:
+ *
+ *      // sky background
+ *      tft_fillGradientV(0, 0, 320, 160, 0x2A9F, 0xCF3F, 1);
+ */
+void tft_fillGradientV(short x, short y, short w, short h, unsigned short c0,
+                       unsigned short c1, unsigned char dither) {
+    short i, j, i0, j0, i1, j1, n;
+    unsigned short c[4];
+    TFT_STAT_PRIM(GRADIENT);
+
+    if (!tft_gradClip(x, y, w, h, &i0, &j0, &i1, &j1))
+        return;
+
+    n = i1 - i0 + 1;
+    tft_gradRamp(c0, c1, j0, j1 - j0 + 1, h - 1);
+
+    tft_beginWrite();
+    tft_setWindow(x + i0, y + j0, x + i1, y + j1);
+    for (j = 0; j <= j1 - j0; j++) {
+        if (!dither) {
+            tft_pushColorN(tft_gradPack(ramp[j] + ROUND), n);
+            continue;
+        }
+        // the row repeats every four pixels
+        for (i = 0; i < 4; i++)
+            c[(x + i0 + i) & 3] = tft_gradPack(ramp[j] +
+                FIELDS(bayer[(y + j0 + j) & 3][(x + i0 + i) & 3]));
+        for (i = 0; i < n; i++)
+            rows[0][i] = c[(x + i0 + i) & 3];
+        tft_pushPixels(rows[0], n);
+    }
+    tft_endWrite();
+}
+
+/**
+ *  Fills the rectangle with top-left vertex (x, y), width w and height h
+ *  with a radial gradient: color c0 at (cx, cy), blending to c1 at
+ *  distance r and beyond. Dithered if `dither` is nonzero.
+ *
+ *  The colors are looked up by whole-pixel distance, which is tracked
+ *  along each row without a square root per pixel.
+ *
+ *  Example:
+ *
+ *      // a glowing button
+ *      tft_fillGradientRadial(100, 100, 60, 60, 130, 130, 42,
+ *                             ILI9340_YELLOW, ILI9340_RED, 1);
+ */
+void tft_fillGradientRadial(short x, short y, short w, short h,
+                            short cx, short cy, short r, unsigned short c0,
+                            unsigned short c1, unsigned char dither) {
+    short i, j, i0, j0, i1, j1, n, px0, px1, py0, py1;
+    long dx, dy, nx, ny, fx, fy, kmin, k, idx;
+    unsigned long d2, kk;
+    TFT_STAT_PRIM(GRADIENT);
+
+    if (!tft_gradClip(x, y, w, h, &i0, &j0, &i1, &j1))
+        return;
+    px0 = x + i0;
+    px1 = x + i1;
+    py0 = y + j0;
+    py1 = y + j1;
+
+    // Distances from the center to the nearest and farthest visible
+    // pixels bound the part of the ramp that is needed.
+    nx = (cx < px0) ? px0 - cx : (cx > px1) ? cx - px1 : 0;
+    ny = (cy < py0) ? py0 - cy : (cy > py1) ? cy - py1 : 0;
+    fx = (cx - px0 > px1 - cx) ? cx - px0 : px1 - cx;
+    fy = (cy - py0 > py1 - cy) ? cy - py0 : py1 - cy;
+    kmin = tft_gradSqrt((unsigned long)(nx * nx) +
+                        (unsigned long)(ny * ny));
+    k = tft_gradSqrt((unsigned long)(fx * fx) +
+                     (unsigned long)(fy * fy)) - kmin + 1;
+    n = (k > RAMP_MAX) ? RAMP_MAX : k;
+    tft_gradRamp(c0, c1, kmin, n, r);
+
+    tft_beginWrite();
+    tft_setWindow(px0, py0, px1, py1);
+    for (j = 0; j <= j1 - j0; j++) {
+        dy = py0 + j - cy;
+        dx = px0 - cx;
+        d2 = (unsigned long)(dx * dx) + (unsigned long)(dy * dy);
+        k = tft_gradSqrt(d2);
+        kk = k * k;
+        for (i = 0; i <= i1 - i0; i++) {
+            idx = k - kmin;
+            if (idx >= n)
+                idx = n - 1;
+            rows[0][i] = tft_gradPack(ramp[idx] +
+                tft_gradThreshold(px0 + i, py0 + j, dither));
+
+            // step right: keep k = floor(sqrt(d2))
+            d2 += 2 * dx + 1;
+            dx++;
+            while (d2 >= kk + 2 * k + 1) {
+                kk += 2 * k + 1;
+                k++;
+            }
+            while (d2 < kk) {
+                k--;
+                kk -= 2 * k + 1;
+            }
+        }
+        tft_pushPixels(rows[0], i1 - i0 + 1);
+    }
+    tft_endWrite();
+}
+
+/**
+ *  Fills the rectangle with top-left vertex (x, y), width w and height h
+ *  with the 24-bit color (r, g, b), dithering between the nearest 5-6-5
+ *  colors so that its average matches.
+ *
+ *  Example:
+ *
+ *      // a warm gray that 5-6-5 can't show exactly
+ *      tft_fillRectDither(0, 200, 320, 40, 0x85, 0x80, 0x7A);
+ */
+void tft_fillRectDither(short x, short y, short w, short h,
+                        unsigned char r, unsigned char g, unsigned char b) {
+    unsigned long v;
+    short i, j, i0, j0, i1, j1, n, k;
+    TFT_STAT_PRIM(GRADIENT);
+
+    if (!tft_gradClip(x, y, w, h, &i0, &j0, &i1, &j1))
+        return;
+
+    v = ((unsigned long)(r * 496 / 255) << 20) |
+        ((unsigned long)(g * 1008 / 255) << 10) |
+         (unsigned long)(b * 496 / 255);
+    n = i1 - i0 + 1;
+    for (k = 0; k < 4; k++) {
+        for (i = 0; i < n; i++)
+            rows[k][i] = tft_gradPack(v + FIELDS(
+                bayer[(y + j0 + k) & 3][(x + i0 + i) & 3]));
+    }
+
+    tft_beginWrite();
+    tft_setWindow(x + i0, y + j0, x + i1, y + j1);
+    for (j = 0; j <= j1 - j0; j++)
+        tft_pushPixels(rows[j & 3], n);
+    tft_endWrite();
+}
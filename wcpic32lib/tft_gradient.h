@@ -0,0 +1,31 @@
+#ifndef TFT_GRADIENT_H
+#define TFT_GRADIENT_H
+
+/**
+ *  @file   tft_gradient.h
+ *
+ *  @brief  Gradient and dithered rectangle fills for the TFT.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *          Each fill works out its colors once, as a ramp or a few rows
+ *          held in RAM, and streams the rectangle through one address
+ *          window, so it takes about as long on the SPI bus as a solid
+ *          fillRect. Dithered fills add a 4x4 ordered (Bayer) pattern
+ *          below the 5-6-5 resolution, which hides the banding a smooth
+ *          gradient otherwise shows.
+ *
+ *  @author Jeff Lutgen
+ */
+
+void tft_fillGradientH(short x, short y, short w, short h, unsigned short c0,
+                       unsigned short c1, unsigned char dither);
+void tft_fillGradientV(short x, short y, short w, short h, unsigned short c0,
+                       unsigned short c1, unsigned char dither);
+void tft_fillGradientRadial(short x, short y, short w, short h,
+                            short cx, short cy, short r, unsigned short c0,
+                            unsigned short c1, unsigned char dither);
+void tft_fillRectDither(short x, short y, short w, short h,
+                        unsigned char r, unsigned char g, unsigned char b);
+
+#endif // TFT_GRADIENT_H
@@ -0,0 +1,146 @@
+/*
+ *  @file   tft_image.c
+ *
+ *  @brief  Compressed full-color images for the TFT, decoded from flash a
+ *          row at a time as they are drawn.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include "tft_image.h"
+#include "tft_master.h"
+#include "private/tft_counters.h"
+
+#ifndef TFT_IMAGE_MAX_WIDTH
+#define TFT_IMAGE_MAX_WIDTH 320
+#endif
+
+/*
+ *  Each pixel of the image, row by row, is one of (bits from the top):
+ *
+ *      00iiiiii            the color at index i of the recent colors
+ *      01rrggbb            previous color plus (r, g, b) - 2
+ *      10gggggg rrrrbbbb   previous color plus (r + g', g - 32, b + g'),
+ *                          where r, b are biased by 8 and g' = (g - 32)/2
+ *                          rounded down
+ *      11nnnnnn            the previous color n + 1 more times (n < 62)
+ *      11111110 hhhhhhhh llllllll   the color hhhhhhhhllllllll
+ *
+ *  Differences are in 5-6-5 units and wrap around. Every decoded color
+ *  except a repeat is stored in the recent colors at index
+ *  (3r + 5g + 7b) % 64. The previous color starts out black, and the
+ *  recent colors all black. Runs may continue from one row to the next.
+ */
+#define OP_INDEX    0x00
+#define OP_DIFF     0x40
+#define OP_LUMA     0x80
+#define OP_RUN      0xC0
+#define OP_RGB      0xFE
+#define OP_MASK     0xC0
+
+#define HASH(r, g, b)   (((r) * 3 + (g) * 5 + (b) * 7) & 63)
+
+static unsigned short line_buf[TFT_IMAGE_MAX_WIDTH];
+
+// Decoder state
+static const unsigned char *src;
+static unsigned short recent[64];
+static unsigned char pr, pg, pb;    // previous color
+static unsigned char run;           // repeats of it still to come
+
+// Decodes the next n pixels into line_buf.
+static void tft_imageRow(short n) {
+    unsigned short *p = line_buf, c;
+    unsigned char op, b2;
+    signed char dg;
+
+    c = (pr << 11) | (pg << 5) | pb;
+    while (n--) {
+        if (run) {
+            run--;
+            *p++ = c;
+            continue;
+        }
+        op = *src++;
+        if (op == OP_RGB) {
+            c = (src[0] << 8) | src[1];
+            src += 2;
+            pr = c >> 11;
+            pg = (c >> 5) & 0x3F;
+            pb = c & 0x1F;
+        } else {
+            switch (op & OP_MASK) {
+                case OP_INDEX:
+                    c = recent[op];
+                    pr = c >> 11;
+                    pg = (c >> 5) & 0x3F;
+                    pb = c & 0x1F;
+                    break;
+                case OP_DIFF:
+                    pr = (pr + ((op >> 4) & 3) - 2) & 0x1F;
+                    pg = (pg + ((op >> 2) & 3) - 2) & 0x3F;
+                    pb = (pb + (op & 3) - 2) & 0x1F;
+                    break;
+                case OP_LUMA:
+                    b2 = *src++;
+                    dg = (op & 0x3F) - 32;
+                    pg = (pg + dg) & 0x3F;
+                    dg = ((op & 0x3F) >> 1) - 16;     // (dg / 2) rounded down
+                    pr = (pr + dg + (b2 >> 4) - 8) & 0x1F;
+                    pb = (pb + dg + (b2 & 0xF) - 8) & 0x1F;
+                    break;
+                default:    // OP_RUN
+                    run = op & 0x3F;    // this pixel plus n more
+                    *p++ = c;
+                    continue;
+            }
+            c = (pr << 11) | (pg << 5) | pb;
+        }
+        recent[HASH(pr, pg, pb)] = c;
+        *p++ = c;
+    }
+}
+
+/**
+ *  Draws `image` with its top left corner at (x, y).
+ *
+ *  The image is decoded a row at a time into a RAM buffer, and the visible
+ *  part of each row is sent through a single address window. Rows below
+ *  the last visible one are not decoded.
+ *
+ *  Example:
+ *
+ *      extern const struct tft_image splash;
+ *      tft_drawImage(0, 0, &splash);
+ */
+void tft_drawImage(short x, short y, const struct tft_image *image) {
+    short w = image->width, h = image->height, i0, i1, j0, j1, j;
+    unsigned char k;
+    TFT_STAT_PRIM(BITMAP);
+
+    if ((w <= 0) || (h <= 0) || (w > TFT_IMAGE_MAX_WIDTH))
+        return;
+    i0 = (x < _clip_x0) ? _clip_x0 - x : 0;
+    j0 = (y < _clip_y0) ? _clip_y0 - y : 0;
+    i1 = (x + w - 1 > _clip_x1) ? _clip_x1 - x : w - 1;
+    j1 = (y + h - 1 > _clip_y1) ? _clip_y1 - y : h - 1;
+    if ((i0 > i1) || (j0 > j1))
+        return;
+
+    src = image->data;
+    for (k = 0; k < 64; k++)
+        recent[k] = 0;
+    pr = pg = pb = 0;
+    run = 0;
+
+    tft_beginWrite();
+    tft_setWindow(x + i0, y + j0, x + i1, y + j1);
+    for (j = 0; j <= j1; j++) {
+        tft_imageRow(w);
+        if (j >= j0)
+            tft_pushPixels(line_buf + i0, i1 - i0 + 1);
+    }
+    tft_endWrite();
+}
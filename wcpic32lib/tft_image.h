@@ -0,0 +1,37 @@
+#ifndef TFT_IMAGE_H
+#define TFT_IMAGE_H
+
+/**
+ *  @file   tft_image.h
+ *
+ *  @brief  Compressed full-color images for the TFT, decoded from flash a
+ *          row at a time as they are drawn.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *          Images are generated with tools/imgconv.py, which writes a .c
+ *          file defining a `const struct tft_image`; declare it in your
+ *          code with `extern const struct tft_image name;`.
+ *
+ *          The format is lossless 5-6-5 RGB, compressed along the lines of
+ *          QOI: each pixel is a repeat of the previous one, a reference to
+ *          one of 64 recently seen colors, a small difference from the
+ *          previous pixel, or a literal. Flat-shaded artwork, icons and
+ *          smooth gradients shrink several-fold (photographs much less),
+ *          and decoding takes only a few instructions per pixel.
+ *
+ *          Images may be up to TFT_IMAGE_MAX_WIDTH (default 320) pixels
+ *          wide, which may be changed by defining it when building the
+ *          library.
+ *
+ *  @author Jeff Lutgen
+ */
+
+struct tft_image {
+    short width, height;
+    const unsigned char *data;
+};
+
+void tft_drawImage(short x, short y, const struct tft_image *image);
+
+#endif // TFT_IMAGE_H
@@ -34,75 +34,231 @@
  ****************************************************/
 
 #include <xc.h>
+#include <stdlib.h>
 #include "private/common.h"
 #include "private/tft_registers.h"
+#include "private/tft_spi.h"
+#include "private/tft_sink.h"
+#include "tft_master.h"
+#include "timebase.h"
 
 unsigned short _width, _height;
 
-static inline void Mode16(void){  // configure SPI1 for 16-bit mode
-    SPI1CONSET = 0x400;
-}
-
-static inline void Mode8(void){  // configure SPI1 for 8-bit mode
-    SPI1CONCLR = 0x400;
-}
+volatile unsigned char _tft_dma_busy;
+
+// Where drawing goes instead of the display, if anywhere (see tft_fb.c)
+const struct tft_sink *_tft_sink;
+
+// The column (CASET) and page (PASET) windows last sent to the controller,
+// so that unchanged halves of an address window need not be re-sent.
+static unsigned short win_x0, win_x1, win_y0, win_y1;
+static unsigned char win_valid;     // WIN_COLUMNS | WIN_PAGES when known
+#define WIN_COLUMNS 0x1
+#define WIN_PAGES   0x2
+
+// While a RAMWR is open (no other command has been sent since), the
+// controller writes the next data word at (next_x, next_y), so a pixel
+// landing exactly there needs no command at all.
+static unsigned char ramwr_open;
+static unsigned short next_x, next_y;
+
+// Clip rectangle (inclusive) and viewport origin, in screen coordinates.
+// _clip_x0 etc. hold the same rectangle relative to the origin.
+#ifndef TFT_CLIP_DEPTH
+#define TFT_CLIP_DEPTH 8
+#endif
+struct clip {
+    short x0, y0, x1, y1;
+    short ox, oy;
+};
+static struct clip clip;
+static struct clip clip_stack[TFT_CLIP_DEPTH];
+static unsigned char clip_depth;
+static unsigned char clip_lost;     // pushes ignored because the stack was full
+short _clip_x0, _clip_y0, _clip_x1, _clip_y1;
+
+// When the window set through tft_setWindow() sticks out of the clip
+// rectangle, the controller only gets the visible part, and pushed pixels
+// are walked through the full window (str_*, screen coordinates) so that
+// only the visible ones (vis_*) are sent.
+static unsigned char stream_clipped;
+static short str_x0, str_x1, str_x, str_y;
+static short vis_x0, vis_y0, vis_x1, vis_y1;
+
+// Nesting depth of tft_beginWrite(). While nonzero, CS stays low between
+// transfers instead of being raised after each one.
+static unsigned char write_depth;
 
 static void tft_begin();
 static void tft_spiwrite8(unsigned char c);
-static void tft_spiwrite16(unsigned short c);
+static void tft_sendcommand(unsigned char c);
 static void tft_writecommand(unsigned char c);
 //static void tft_writecommand16(unsigned short c);
 static void tft_writedata(unsigned char c);
-static void tft_writedata16(unsigned short c);
-static void tft_setAddrWindow(unsigned short x0, unsigned short y0,
-                              unsigned short x1, unsigned short y1);
-
-static void delay_ms(unsigned long);
 
-#define _dc         LATBbits.LATB9
-#define TRIS_dc     TRISBbits.TRISB9
-#define _dc_high()  {LATBSET = 1 << 9;}
-#define _dc_low()   {LATBCLR = 1 << 9;}
-
-#define _cs         LATBbits.LATB8
-#define TRIS_cs     TRISBbits.TRISB8
-#define _cs_high()  {LATBSET = 1 << 8;}
-#define _cs_low()   {LATBCLR = 1 << 8;}
-
-#define _rst        LATBbits.LATB2
-#define TRIS_rst    TRISBbits.TRISB2
-#define _rst_high() {LATBSET = 1 << 2;}
-#define _rst_low()  {LATBCLR = 1 << 2;}
-
-#define SPI_freq    20000000  // 20 MHz
+static void tft_sendbytes(const unsigned char *p, unsigned char n);
+static void tft_setAddress(short x0, short y0, short x1, short y1);
+static void tft_window(short x0, short y0, short x1, short y1);
+static void tft_sendPixels(const unsigned short *buf, unsigned long n);
+static void tft_sendColor(unsigned short color, unsigned long n);
+
+// Fastest SPI clock to use. The actual rate is PBCLK divided by the
+// smallest even number (at least 2) that doesn't exceed it.
+#ifndef TFT_SPI_FREQ
+#define TFT_SPI_FREQ    20000000  // 20 MHz
+#endif
+
+// SPI clock for reading the display. The controller's serial read cycle
+// is much longer than its write cycle (150 ns vs. 100 ns).
+#ifndef TFT_SPI_READ_FREQ
+#define TFT_SPI_READ_FREQ   6000000  // 6 MHz
+#endif
+
+// SPI1BRG values for writing and for reading
+static unsigned short brg_write, brg_read;
+
+// Pushes of at least this many pixels go out as 32-bit frames, two pixels
+// per FIFO entry. Shorter ones aren't worth draining the FIFO twice to
+// switch frame size.
+#define PACK_MIN    16
+
+// Controller initialization sequence. Each entry is a command byte, the
+// number of argument bytes (ORed with INIT_DELAY if the command must be
+// followed by a pause), the arguments, and then the pause in ms if any.
+// A zero command byte ends the table.
+#define INIT_DELAY  0x80
+
+static const unsigned char init_seq[] = {
+    0xEF, 3, 0x03, 0x80, 0x02,
+    0xCF, 3, 0x00, 0xC1, 0x30,
+    0xED, 4, 0x64, 0x03, 0x12, 0x81,
+    0xE8, 3, 0x85, 0x00, 0x78,
+    0xCB, 5, 0x39, 0x2C, 0x00, 0x34, 0x02,
+    0xF7, 1, 0x20,
+    0xEA, 2, 0x00, 0x00,
+    ILI9340_PWCTR1, 1, 0x23,            // Power control: VRH[5:0]
+    ILI9340_PWCTR2, 1, 0x10,            // Power control: SAP[2:0];BT[3:0]
+    ILI9340_VMCTR1, 2, 0x3e, 0x28,      // VCM control
+    ILI9340_VMCTR2, 1, 0x86,            // VCM control2
+    ILI9340_MADCTL, 1, ILI9340_MADCTL_MX | ILI9340_MADCTL_BGR,
+    ILI9340_PIXFMT, 1, 0x55,            // 16 bits per pixel
+    ILI9340_FRMCTR1, 2, 0x00, 0x18,
+    ILI9340_DFUNCTR, 3, 0x08, 0x82, 0x27,   // Display Function Control
+    0xF2, 1, 0x00,                      // 3Gamma Function Disable
+    ILI9340_GAMMASET, 1, 0x01,          // Gamma curve selected
+    ILI9340_GMCTRP1, 15,                // Set Gamma
+        0x0F, 0x31, 0x2B, 0x0C, 0x0E, 0x08, 0x4E, 0xF1,
+        0x37, 0x07, 0x10, 0x03, 0x0E, 0x09, 0x00,
+    ILI9340_GMCTRN1, 15 | INIT_DELAY,   // Set Gamma
+        0x00, 0x0E, 0x14, 0x03, 0x11, 0x07, 0x31, 0xC1,
+        0x48, 0x08, 0x0F, 0x0C, 0x31, 0x36, 0x0F,
+        120,    // Sleep Out may not follow reset any sooner than this
+    ILI9340_SLPOUT, 0 | INIT_DELAY, 120,    // Exit Sleep
+    ILI9340_DISPON, 0,                  // Display on
+    0
+};
+
+// Progress of tft_initStart() / tft_initPoll()
+static enum { INIT_RESET, INIT_TABLE, INIT_DONE } init_state = INIT_DONE;
+static const unsigned char *init_ptr;       // next entry of init_seq
+static unsigned long long init_deadline;    // end of the pause in progress
 
 /**
  *  Initializes the TFT display and configures SPI1 module on PIC to
  *  communicate with TFT.
  *
+ *  Blocks for about 250 ms while the display resets and wakes up; to do
+ *  other work in the meantime, use tft_initStart() and tft_initPoll()
+ *  instead.
+ *
  *  Pins used:
  *
  *      TFT     PIC
  *      ----    ---------------------
  *      MOSI    RB11 (pin 22) --> SDO1
+ *      MISO    RA1  (pin 3)  <-- SDI1
  *      SCK     RB14 (pin 25) --> SCK1
  *      D/C     RB9  (pin 18)
  *      CS      RB8  (pin 17)
  *      RST     RB2  (pin 6)
+ *      TE      RB7  (pin 16) --> INT0 (optional; see tft_sync.h)
  *
  *  In addition, connect TFT's VIN to 3.3V supply and GND to ground;
  *  can leave BL (backlight power) disconnected, since TFT screen
  *  is bright enough without backlight.
  */
 void tft_init() {
+    tft_initStart();
+    while (!tft_initPoll()) { ; }
+}
+
+/**
+ *  Starts initializing the TFT display, as tft_init() does, but returns
+ *  right away. Call tft_initPoll() until it returns nonzero before using
+ *  the display.
+ *
+ *  Example:
+ *
+ *      tft_initStart();
+ *      dac_init();             // bring up other peripherals meanwhile
+ *      ioe_init();
+ *      while (!tft_initPoll())
+ *          ;
+ */
+void tft_initStart(void) {
     _width = ILI9340_TFTWIDTH;
     _height = ILI9340_TFTHEIGHT;
+    tft_resetClip();
     // RPB11R = 3;  // Map RPB11 --> SDO1. Goes to MOSI on TFT.
     PPSOutput(2, RPB11, SDO1); // Map RPB11 --> SDO1. Goes to MOSI on TFT.
+    PPSInput(2, SDI1, RPA1);   // Map RPA1 --> SDI1. Comes from MISO on TFT.
+    ANSELACLR = 1 << 1;        // RA1 is analog (AN1) by default
+    TRISASET = 1 << 1;
 
     tft_begin();
 }
 
+/**
+ *  Advances the initialization started by tft_initStart(), sending the
+ *  next part of the sequence if the pause before it is over. Returns
+ *  nonzero once the display is ready. Never blocks for more than the
+ *  time to send a few hundred bytes.
+ */
+int tft_initPoll(void) {
+    unsigned char cmd, n;
+
+    if (init_state == INIT_DONE)
+        return 1;
+    if (!deadline_passed(init_deadline))
+        return 0;
+
+    if (init_state == INIT_RESET) {
+        _rst_high();
+        init_state = INIT_TABLE;
+        init_deadline = deadline_ms(5);  // no commands for 5 ms after reset
+        return 0;
+    }
+
+    // Send commands up to the next pause, all in one transaction
+    tft_beginWrite();
+    while ((cmd = *init_ptr++) != 0) {
+        n = *init_ptr++;
+        tft_sendcommand(cmd);
+        tft_sendbytes(init_ptr, n & ~INIT_DELAY);
+        init_ptr += n & ~INIT_DELAY;
+        if (n & INIT_DELAY) {
+            init_deadline = deadline_ms(*init_ptr++);
+            break;
+        }
+    }
+    tft_endWrite();
+
+    if (cmd != 0)
+        return 0;
+    init_state = INIT_DONE;
+    return 1;
+}
+
 static void tft_spiwrite8(unsigned char c) {   // Transfer one byte c to SPI
     /* The default mode for me is to transfer 16-bits at once
      * However, it is necessary sometimes to transfer only 8-bits at a time
@@ -110,25 +266,54 @@ static void tft_spiwrite8(unsigned char c) {   // Transfer one byte c to SPI
      * So the default mode is 16-bit mode and is switched to 8-bit mode when
      * required, and then switched back at the end of the function
      */
+    TFT_WAIT(SPI1STATbits.SPIBUSY); // streamed pixels may still be in flight
     Mode8(); // switch to 8-bit mode
-    while (TxBufFullSPI1());
     WriteSPI1(c);
-    while (SPI1STATbits.SPIBUSY); // wait for it to end of transaction
+    TFT_STAT_ADD(words, 1);
+    TFT_WAIT(SPI1STATbits.SPIBUSY); // wait for it to end of transaction
     Mode16(); // switch back to 16-bit mode
 }
 
-static void tft_spiwrite16(unsigned short c){  // Transfer two bytes "c" to SPI
-    while (TxBufFullSPI1());
+// Sends n data bytes from p (CS must already be low, D/C high), switching
+// to 8-bit mode just once for all of them.
+static void tft_sendbytes(const unsigned char *p, unsigned char n) {
+    if (n == 0)
+        return;
+    TFT_STAT_ADD(words, n);
+    TFT_WAIT(SPI1STATbits.SPIBUSY);
+    Mode8();
+    while (n--) {
+        TFT_WAIT(TxBufFullSPI1());
+        WriteSPI1(*p++);
+    }
+    TFT_WAIT(SPI1STATbits.SPIBUSY);
+    Mode16();
+}
+
+// Queues a 16-bit data word. Only waits for room in the FIFO, not for the
+// word to go out.
+static inline void tft_senddata16(unsigned short c) {
+    TFT_WAIT(TxBufFullSPI1());
     WriteSPI1(c);
-    while (SPI1STATbits.SPIBUSY); // wait for it to end of transaction
+    TFT_STAT_ADD(words, 1);
 }
 
+// Sends command byte c (CS must already be low), leaving D/C high and
+// SPI1 in 16-bit mode, ready for argument or pixel words.
+static void tft_sendcommand(unsigned char c) {
+    TFT_WAIT(SPI1STATbits.SPIBUSY); // D/C must not change mid-transfer
+    _dc_low();
+    tft_spiwrite8(c);
+    _dc_high();
+}
 
 static void tft_writecommand(unsigned char c) {
-    _dc_low();
+    tft_waitDMA();
+    ramwr_open = 0;     // any command ends a memory write
     _cs_low();
-    tft_spiwrite8(c);
-    _cs_high();
+    tft_sendcommand(c);
+    if (!write_depth)
+        _cs_high();
 }
 
 //static void tft_writecommand16(unsigned short c) {
@@ -143,18 +328,24 @@ static void tft_writedata(unsigned char c) {
     _dc_high();
     _cs_low();
     tft_spiwrite8(c);
-    _cs_high();
+    if (!write_depth)
+        _cs_high();
 }
 
-static void tft_writedata16(unsigned short c) {
-    _dc_high();
-    _cs_low();
-    tft_spiwrite16(c);
-    _cs_high();
+// Returns the SPI1BRG value giving the fastest SPI clock not above freq.
+static unsigned short tft_spibrg(unsigned long freq) {
+    unsigned div;
+
+    div = (_pbclk + freq - 1) / freq;
+    div += div & 1;
+    if (div < 2)
+        div = 2;
+    return div / 2 - 1;
 }
 
+// Sets up the pins and SPI1 and puts the display into reset, leaving
+// tft_initPoll() to do the rest.
 static void tft_begin() {
-
     TRIS_rst = 0;
     _rst_low();
     TRIS_dc = 0;
@@ -163,256 +354,472 @@ static void tft_begin() {
     _dc_low();
     _cs_high();
 
-    SpiChnOpen(1, SPI_OPEN_MSTEN | SPI_OPEN_MODE8 | SPI_OPEN_ON |
-                  SPI_OPEN_DISSDI | SPI_OPEN_CKE_REV , _pbclk/SPI_freq);
+    win_valid = 0;
+    ramwr_open = 0;
 
-    // Start with 8-bit mode for initialization - move to 16-bit mode once
-    // that's done
+    brg_write = tft_spibrg(TFT_SPI_FREQ);
+    brg_read = tft_spibrg(TFT_SPI_READ_FREQ);
 
-    _rst_high();
-    delay_ms(5);
-    _rst_low();
-    delay_ms(20);
-    _rst_high();
-    delay_ms(150);
-
-    tft_writecommand(0xEF);
-    tft_writedata(0x03);
-    tft_writedata(0x80);
-    tft_writedata(0x02);
-
-    tft_writecommand(0xCF);
-    tft_writedata(0x00);
-    tft_writedata(0xC1);
-    tft_writedata(0x30);
-
-    tft_writecommand(0xED);
-    tft_writedata(0x64);
-    tft_writedata(0x03);
-    tft_writedata(0x12);
-    tft_writedata(0x81);
-
-    tft_writecommand(0xE8);
-    tft_writedata(0x85);
-    tft_writedata(0x00);
-    tft_writedata(0x78);
-
-    tft_writecommand(0xCB);
-    tft_writedata(0x39);
-    tft_writedata(0x2C);
-    tft_writedata(0x00);
-    tft_writedata(0x34);
-    tft_writedata(0x02);
-
-    tft_writecommand(0xF7);
-    tft_writedata(0x20);
-
-    tft_writecommand(0xEA);
-    tft_writedata(0x00);
-    tft_writedata(0x00);
-
-    tft_writecommand(ILI9340_PWCTR1);    //Power control
-    tft_writedata(0x23);   //VRH[5:0]
-
-    tft_writecommand(ILI9340_PWCTR2);    //Power control
-    tft_writedata(0x10);   //SAP[2:0];BT[3:0]
-
-    tft_writecommand(ILI9340_VMCTR1);    //VCM control
-    tft_writedata(0x3e);
-    tft_writedata(0x28);
-
-    tft_writecommand(ILI9340_VMCTR2);    //VCM control2
-    tft_writedata(0x86);
-
-    tft_writecommand(ILI9340_MADCTL);    // Memory Access Control
-    tft_writedata(ILI9340_MADCTL_MX | ILI9340_MADCTL_BGR);
-
-    tft_writecommand(ILI9340_PIXFMT);
-    tft_writedata(0x55);
-
-    tft_writecommand(ILI9340_FRMCTR1);
-    tft_writedata(0x00);
-    tft_writedata(0x18);
-
-    tft_writecommand(ILI9340_DFUNCTR);    // Display Function Control
-    tft_writedata(0x08);
-    tft_writedata(0x82);
-    tft_writedata(0x27);
-
-    tft_writecommand(0xF2);    // 3Gamma Function Disable
-    tft_writedata(0x00);
-
-    tft_writecommand(ILI9340_GAMMASET);    //Gamma curve selected
-    tft_writedata(0x01);
-
-    tft_writecommand(ILI9340_GMCTRP1);    //Set Gamma
-    tft_writedata(0x0F);
-    tft_writedata(0x31);
-    tft_writedata(0x2B);
-    tft_writedata(0x0C);
-    tft_writedata(0x0E);
-    tft_writedata(0x08);
-    tft_writedata(0x4E);
-    tft_writedata(0xF1);
-    tft_writedata(0x37);
-    tft_writedata(0x07);
-    tft_writedata(0x10);
-    tft_writedata(0x03);
-    tft_writedata(0x0E);
-    tft_writedata(0x09);
-    tft_writedata(0x00);
-
-    tft_writecommand(ILI9340_GMCTRN1);    //Set Gamma
-    tft_writedata(0x00);
-    tft_writedata(0x0E);
-    tft_writedata(0x14);
-    tft_writedata(0x03);
-    tft_writedata(0x11);
-    tft_writedata(0x07);
-    tft_writedata(0x31);
-    tft_writedata(0xC1);
-    tft_writedata(0x48);
-    tft_writedata(0x08);
-    tft_writedata(0x0F);
-    tft_writedata(0x0C);
-    tft_writedata(0x31);
-    tft_writedata(0x36);
-    tft_writedata(0x0F);
-
-    tft_writecommand(ILI9340_SLPOUT);    //Exit Sleep
-    delay_ms(120);
-    tft_writecommand(ILI9340_DISPON);    //Display on
-
-    // Now move to 16-bit mode to speed things up for display
+    // Enhanced buffer mode gives us an 8-word transmit FIFO (4 words in
+    // 32-bit mode); the transmit interrupt event (used to pace DMA) fires
+    // whenever the FIFO has room.
+    SpiChnOpen(1, SPI_OPEN_MSTEN | SPI_OPEN_MODE8 | SPI_OPEN_ON |
+                  SPI_OPEN_CKE_REV | SPI_OPEN_ENHBUF |
+                  SPI_OPEN_TBE_NOT_FULL, 2 * (brg_write + 1));
     Mode16();
+
+    // Hold reset low for 1 ms (at least 10 us are needed)
+    init_ptr = init_seq;
+    init_state = INIT_RESET;
+    init_deadline = deadline_ms(1);
 }
 
+/**
+ *  Sets the display RAM window to (x0, y0)..(x1, y1) inclusive, so that
+ *  subsequent tft_pushPixels() and tft_pushColorN() calls fill it row by
+ *  row, starting at (x0, y0).
+ *
+ *  The window may stick out of the clip rectangle (see tft_pushClip()) or
+ *  the screen: pixels are still pushed for the whole window, but only the
+ *  visible ones are sent.
+ */
+void tft_setWindow(short x0, short y0, short x1, short y1) {
+    x0 += clip.ox;
+    x1 += clip.ox;
+    y0 += clip.oy;
+    y1 += clip.oy;
+    vis_x0 = (x0 < clip.x0) ? clip.x0 : x0;
+    vis_y0 = (y0 < clip.y0) ? clip.y0 : y0;
+    vis_x1 = (x1 > clip.x1) ? clip.x1 : x1;
+    vis_y1 = (y1 > clip.y1) ? clip.y1 : y1;
+    if ((vis_x0 <= vis_x1) && (vis_y0 <= vis_y1))
+        tft_window(vis_x0, vis_y0, vis_x1, vis_y1);
+    str_x0 = x0;
+    str_x1 = x1;
+    str_x = x0;
+    str_y = y0;
+    stream_clipped = (vis_x0 != x0) || (vis_y0 != y0) ||
+                     (vis_x1 != x1) || (vis_y1 != y1);
+}
 
-static void tft_setAddrWindow(unsigned short x0, unsigned short y0, unsigned short x1, unsigned short y1) {
+// Declared in private/tft_sink.h
+void tft_screenWindow(short x0, short y0, short x1, short y1) {
+    tft_window(x0, y0, x1, y1);
+}
 
-    tft_writecommand(ILI9340_CASET); // Column addr set
-    tft_writedata16(x0);
-    tft_writedata16(x1);
+/*
+ *  Sets the window (x0, y0)..(x1, y1), in screen coordinates and already
+ *  clipped, and opens a RAMWR.
+ *
+ *  Only the halves of the window that differ from what the controller
+ *  already holds are sent. If an open RAMWR would put the next data word
+ *  at (x0, y0) and wrap rows the same way, nothing is sent at all.
+ */
+static void tft_window(short x0, short y0, short x1, short y1) {
+    stream_clipped = 0;
+    if (_tft_sink) {
+        _tft_sink->setWindow(x0, y0, x1, y1);
+        return;
+    }
 
-    tft_writecommand(ILI9340_PASET); // Row addr set
-    tft_writedata16(y0);
-    tft_writedata16(y1);
+    if (ramwr_open && (next_x == x0) && (next_y == y0) &&
+        (win_x0 == x0) && (win_x1 == x1) && (y1 <= win_y1))
+        return;
 
-    tft_writecommand(ILI9340_RAMWR); // write to RAM
+    tft_beginWrite();
+    tft_setAddress(x0, y0, x1, y1);
+    tft_sendcommand(ILI9340_RAMWR); // write to RAM
+    ramwr_open = 1;
+    next_x = x0;
+    next_y = y0;
+    tft_endWrite();
 }
 
+// Sends whichever of CASET and PASET differ from what the controller
+// already holds. CS must already be low.
+static void tft_setAddress(short x0, short y0, short x1, short y1) {
+    ramwr_open = 0;
+    TFT_STAT_ADD(windows, 1);
+
+    if (!(win_valid & WIN_COLUMNS) || (win_x0 != x0) || (win_x1 != x1)) {
+        tft_sendcommand(ILI9340_CASET); // Column addr set
+        tft_senddata16(x0);
+        tft_senddata16(x1);
+        win_x0 = x0;
+        win_x1 = x1;
+    }
 
-//static void tft_pushColor(unsigned short color) {
-//    _dc_high();
-//    _cs_low();
-//    tft_spiwrite16(color);
-//    _cs_high();
-//}
+    if (!(win_valid & WIN_PAGES) || (win_y0 != y0) || (win_y1 != y1)) {
+        tft_sendcommand(ILI9340_PASET); // Row addr set
+        tft_senddata16(y0);
+        tft_senddata16(y1);
+        win_y0 = y0;
+        win_y1 = y1;
+    }
+    win_valid = WIN_COLUMNS | WIN_PAGES;
+}
+
+/*
+ *  Records that n pixels have been written since the last
+ *  tft_setWindow(), so the controller's write position can be tracked.
+ */
+void tft_windowWritten(unsigned long n) {
+    unsigned long col, row;
 
-#define NOP asm("nop");
-#define wait16 NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
-#define wait8  NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
-#define wait12 NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
-#define wait15 NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
+    if (!ramwr_open)
+        return;
+    col = next_x - win_x0 + n;
+    if (col <= win_x1 - win_x0) {   // still on the same row
+        next_x += n;
+        return;
+    }
+    row = next_y + col / (win_x1 - win_x0 + 1);
+    if (row > win_y1) {
+        ramwr_open = 0; // past the end of the window
+        return;
+    }
+    next_x = win_x0 + col % (win_x1 - win_x0 + 1);
+    next_y = row;
+}
+
+/*
+ *  Sends command c followed by n argument bytes from args, for commands
+ *  that only other TFT modules use.
+ */
+void tft_command(unsigned char c, const unsigned char *args, unsigned char n) {
+    tft_beginWrite();
+    tft_writecommand(c);
+    tft_sendbytes(args, n);
+    tft_endWrite();
+}
 
 /**
- * Draws a pixel at location (x,y) in the given color.
+ *  Starts a write transaction. CS is held low until the matching
+ *  tft_endWrite(), so that tft_setWindow(), tft_pushPixels() and
+ *  tft_pushColorN() calls in between go out as one continuous burst.
+ *
+ *  Transactions may be nested. Do not start a DMA transfer (tft_dma.h)
+ *  inside a transaction.
+ *
+ *  Example:
+ *
+ *      // draw a 16x16 sprite
+ *      tft_beginWrite();
+ *      tft_setWindow(x, y, x+15, y+15);
+ *      tft_pushPixels(sprite, 16*16);
+ *      tft_endWrite();
  */
-void tft_drawPixel(short x, short y, unsigned short color) {
-    if((x < 0) ||(x >= _width) || (y < 0) || (y >= _height))
-        return;
+void tft_beginWrite(void) {
+    if (write_depth++ == 0) {
+        tft_waitDMA();
+        _cs_low();
+    }
+}
 
-    _dc_low();
-    _cs_low();
-    Mode8(); // switch to 8-bit mode
-    while (TxBufFullSPI1()) { ; }
-    WriteSPI1(ILI9340_CASET); // column address set
-    wait16;
-    Mode16(); // switch back to 16-bit mode
-    _cs_high();
+/**
+ *  Ends a write transaction started by tft_beginWrite(), releasing CS once
+ *  the last pixel has been sent.
+ */
+void tft_endWrite(void) {
+    if (write_depth && --write_depth == 0) {
+        TFT_WAIT(SPI1STATbits.SPIBUSY); // wait for the last word to go out
+        _cs_high();
+    }
+}
 
-    _dc_high();
-    _cs_low();
-    WriteSPI1(x);
-    wait16;wait16;wait8;
-    _cs_high();
+/*
+ *  Walks n pixels (from `buf`, or of `color` if `buf` is NULL) through a
+ *  window that is partly clipped away, sending the visible part of each
+ *  row.
+ */
+static void tft_pushClipped(const unsigned short *buf, unsigned short color,
+                            unsigned long n) {
+    unsigned long k;
+    short a, b;
+
+    while (n && (str_y <= vis_y1)) {
+        k = str_x1 - str_x + 1;     // left on this row of the window
+        if (k > n)
+            k = n;
+        if (str_y >= vis_y0) {
+            a = (str_x < vis_x0) ? vis_x0 : str_x;
+            b = (str_x + (long)k - 1 > vis_x1) ? vis_x1 : str_x + k - 1;
+            if (a <= b) {
+                if (buf)
+                    tft_sendPixels(buf + (a - str_x), b - a + 1);
+                else
+                    tft_sendColor(color, b - a + 1);
+            }
+        }
+        if (buf)
+            buf += k;
+        n -= k;
+        str_x += k;
+        if (str_x > str_x1) {
+            str_x = str_x0;
+            str_y++;
+        }
+    }
+}
 
-    _cs_low();
-    WriteSPI1(x+1);
-    wait16;wait16;wait8;
-    _cs_high();
+/**
+ *  Sends n pixels (5-6-5 RGB) from `buf` into the current window; see
+ *  tft_setWindow().
+ */
+void tft_pushPixels(const unsigned short *buf, unsigned long n) {
+    TFT_STAT_PRIM(PUSH);
 
-    _dc_low();
-    _cs_low();
-    Mode8(); // switch to 8-bit mode
-    WriteSPI1(ILI9340_PASET); // row address set
-    wait16;wait8;
-    Mode16(); // switch back to 16-bit mode
-    _cs_high();
+    if (stream_clipped)
+        tft_pushClipped(buf, 0, n);
+    else
+        tft_sendPixels(buf, n);
+}
 
-    _dc_high();
-    _cs_low();
-    WriteSPI1(y);
-    wait16;wait16;wait8;
-    _cs_high();
+/**
+ *  Sends n pixels of the given color into the current window; see
+ *  tft_setWindow().
+ */
+void tft_pushColorN(unsigned short color, unsigned long n) {
+    TFT_STAT_PRIM(PUSH);
 
-    _cs_low();
-    WriteSPI1(y+1);
-    wait16;wait16;wait8;
-    _cs_high();
+    if (stream_clipped)
+        tft_pushClipped(NULL, color, n);
+    else
+        tft_sendColor(color, n);
+}
 
-    _dc_low();
+// Sends n pixels from `buf` into the window last set by tft_window().
+static void tft_sendPixels(const unsigned short *buf, unsigned long n) {
+    unsigned long pairs;
+
+    if (_tft_sink) {
+        _tft_sink->pushPixels(buf, n);
+        return;
+    }
+    TFT_STAT_ADD(pixels, n);
+    TFT_STAT_ADD(words, n >= PACK_MIN ? (n >> 1) + (n & 1) : n);
+    tft_windowWritten(n);
+    _dc_high();
     _cs_low();
-    Mode8(); // switch to 8-bit mode
-    WriteSPI1(ILI9340_RAMWR); // write to RAM
-    wait16;wait8;
-    Mode16(); // switch back to 16-bit mode
-    _cs_high();
+    if (n >= PACK_MIN) {
+        pairs = n >> 1;
+        n &= 1;
+        TFT_WAIT(SPI1STATbits.SPIBUSY);
+        Mode32();
+        while (pairs--) {
+            TFT_WAIT(TxBufFullSPI1());
+            WriteSPI1(((unsigned long)buf[0] << 16) | buf[1]);
+            buf += 2;
+        }
+        TFT_WAIT(SPI1STATbits.SPIBUSY);
+        Mode16();
+    }
+    while (n--) {
+        TFT_WAIT(TxBufFullSPI1());
+        WriteSPI1(*buf++);
+    }
+    if (!write_depth) {
+        TFT_WAIT(SPI1STATbits.SPIBUSY);
+        _cs_high();
+    }
+}
+
+// Sends n pixels of the given color into the window last set by
+// tft_window().
+static void tft_sendColor(unsigned short color, unsigned long n) {
+    unsigned long pairs;
 
+    if (_tft_sink) {
+        _tft_sink->pushColorN(color, n);
+        return;
+    }
+    TFT_STAT_ADD(pixels, n);
+    TFT_STAT_ADD(words, n >= PACK_MIN ? (n >> 1) + (n & 1) : n);
+    tft_windowWritten(n);
     _dc_high();
     _cs_low();
-    WriteSPI1(color);
-    wait16;wait16;wait8;
-    _cs_high();
+    if (n >= PACK_MIN) {
+        pairs = n >> 1;
+        n &= 1;
+        TFT_WAIT(SPI1STATbits.SPIBUSY);
+        Mode32();
+        while (pairs--) {
+            TFT_WAIT(TxBufFullSPI1());
+            WriteSPI1(((unsigned long)color << 16) | color);
+        }
+        TFT_WAIT(SPI1STATbits.SPIBUSY);
+        Mode16();
+    }
+    while (n--) {
+        TFT_WAIT(TxBufFullSPI1());
+        WriteSPI1(color);
+    }
+    if (!write_depth) {
+        TFT_WAIT(SPI1STATbits.SPIBUSY);
+        _cs_high();
+    }
 }
 
 /**
- *  Draws a vertical line at from (x, y) to (x, y+h-1) in the given color.
+ *  Reads the rectangle with top-left vertex (x, y), width w and height h
+ *  back from display memory into `buf` (w*h 5-6-5 RGB values, row by row).
+ *  The rectangle must lie entirely on the screen, but need not be inside
+ *  the clip rectangle. While drawing goes to a framebuffer (see
+ *  tft_fb.h), this reads the framebuffer instead.
+ *
+ *  The controller sends 18-bit pixels, one byte per component, and reads
+ *  need a slower SPI clock (TFT_SPI_READ_FREQ), so reading takes about
+ *  five times as long as writing the same rectangle.
+ *
+ *  Example:
+ *
+ *      // save what's under a 40x20 pop-up, then restore it
+ *      unsigned short under[40*20];
+ *      tft_readRect(x, y, 40, 20, under);
+ *      ...
+ *      tft_setWindow(x, y, x+39, y+19);
+ *      tft_pushPixels(under, 40*20);
  */
-void tft_drawFastVLine(short x, short y, short h, unsigned short color) {
-    // Rudimentary clipping
-    if((x >= _width) || (y >= _height)) return;
+void tft_readRect(short x, short y, short w, short h, unsigned short *buf) {
+    unsigned long n, sent, rcvd;
+    unsigned char rgb[3];
+
+    x += clip.ox;
+    y += clip.oy;
+    if ((x < 0) || (y < 0) || (w <= 0) || (h <= 0) ||
+        (x + w > _width) || (y + h > _height))
+        return;
+    if (_tft_sink) {
+        _tft_sink->readRect(x, y, w, h, buf);
+        return;
+    }
+
+    n = 3 * (unsigned long)w * h + 1;   // a dummy byte comes first
+    tft_beginWrite();
+    tft_setAddress(x, y, x + w - 1, y + h - 1);
+    tft_sendcommand(ILI9340_RAMRD);
+
+    // Everything received while writing is junk: flush it and clear any
+    // overflow, which would otherwise stop reception.
+    while (!SPI1STATbits.SPIRBE)
+        (void)ReadSPI1();
+    SPI1STATCLR = _SPI1STAT_SPIROV_MASK;
+    Mode8();
+    SPI1BRG = brg_read;
+
+    // Keep a few bytes in flight; the receive FIFO holds 16.
+    for (sent = rcvd = 0; rcvd < n; ) {
+        if ((sent < n) && (sent - rcvd < 8) && !TxBufFullSPI1()) {
+            WriteSPI1(0);
+            TFT_STAT_ADD(words, 1);
+            sent++;
+        }
+        if (!SPI1STATbits.SPIRBE) {
+            rgb[rcvd % 3] = ReadSPI1();
+            if ((rcvd != 0) && (rcvd % 3 == 0))
+                *buf++ = tft_Color565(rgb[1], rgb[2], rgb[0]);
+            rcvd++;
+        }
+    }
 
-    if((y+h-1) >= _height)
-        h = _height-y;
+    SPI1BRG = brg_write;
+    Mode16();
+    tft_endWrite();     // the read ends at CS high or the next command
+}
 
-    tft_setAddrWindow(x, y, x, y+h-1);
+/**
+ *  Returns the color (5-6-5 RGB) of the pixel at (x, y), or 0 if (x, y)
+ *  is off the screen.
+ */
+unsigned short tft_readPixel(short x, short y) {
+    unsigned short c = 0;
 
-    _dc_high();
-    _cs_low();
-    while (h--) {
-        tft_spiwrite16(color);
+    tft_readRect(x, y, 1, 1, &c);
+    return c;
+}
+
+
+/*
+ *  Moves the rectangle with top-left vertex (*x, *y), width *w and height
+ *  *h into screen coordinates and clips it to the clip rectangle. Returns
+ *  0 if nothing is left.
+ */
+static int tft_clipRect(short *x, short *y, short *w, short *h) {
+    int x0 = *x + clip.ox, y0 = *y + clip.oy;
+    int x1 = x0 + *w - 1, y1 = y0 + *h - 1;
+
+    if (x0 < clip.x0)
+        x0 = clip.x0;
+    if (y0 < clip.y0)
+        y0 = clip.y0;
+    if (x1 > clip.x1)
+        x1 = clip.x1;
+    if (y1 > clip.y1)
+        y1 = clip.y1;
+    if ((x0 > x1) || (y0 > y1))
+        return 0;
+    *x = x0;
+    *y = y0;
+    *w = x1 - x0 + 1;
+    *h = y1 - y0 + 1;
+    return 1;
+}
+
+/**
+ * Draws a pixel at location (x,y) in the given color.
+ *
+ * For long runs of pixels, wrap the calls in tft_beginWrite() and
+ * tft_endWrite(); each pixel then just queues its words in the SPI FIFO.
+ */
+void tft_drawPixel(short x, short y, unsigned short color) {
+    TFT_STAT_PRIM(PIXEL);
+
+    x += clip.ox;
+    y += clip.oy;
+    if ((x < clip.x0) || (x > clip.x1) || (y < clip.y0) || (y > clip.y1))
+        return;
+    if (_tft_sink) {
+        _tft_sink->drawPixel(x, y, color);
+        return;
     }
-    _cs_high();
+
+    tft_beginWrite();
+    // Pixels get a window reaching to the right and bottom edges of the
+    // screen, so runs along a row (or column) only re-send the column (or
+    // page) address, and a pixel that follows the previous one in the
+    // window needs no commands at all.
+    if (!ramwr_open || (x != next_x) || (y != next_y))
+        tft_window(x, y, _width - 1, _height - 1);
+    tft_senddata16(color);
+    TFT_STAT_ADD(pixels, 1);
+    tft_windowWritten(1);
+    tft_endWrite();
 }
 
 /**
- *  Draws a horizontal line from (x, y) to (x+w-1, y) in the given color.
+ *  Draws a vertical line at from (x, y) to (x, y+h-1) in the given color.
  */
-void tft_drawFastHLine(short x, short y, short w, unsigned short color) {
+void tft_drawFastVLine(short x, short y, short h, unsigned short color) {
+    short w = 1;
+    TFT_STAT_PRIM(VLINE);
 
+    if (!tft_clipRect(&x, &y, &w, &h))
+        return;
+    tft_window(x, y, x, y+h-1);
+    tft_sendColor(color, h);
+}
 
-    // Rudimentary clipping
-    if((x >= _width) || (y >= _height)) return;
-    if((x+w-1) >= _width)  w = _width-x;
-    tft_setAddrWindow(x, y, x+w-1, y);
+/**
+ *  Draws a horizontal line from (x, y) to (x+w-1, y) in the given color.
+ */
+void tft_drawFastHLine(short x, short y, short w, unsigned short color) {
+    short h = 1;
+    TFT_STAT_PRIM(HLINE);
 
-    _dc_high();
-    _cs_low();
-    while (w--) {
-        tft_spiwrite16(color);
-    }
-    _cs_high();
+    if (!tft_clipRect(&x, &y, &w, &h))
+        return;
+    tft_window(x, y, x+w-1, y);
+    tft_sendColor(color, w);
 }
 
 /**
@@ -421,31 +828,123 @@ void tft_drawFastHLine(short x, short y, short w, unsigned short color) {
  */
 void tft_fillRect(short x, short y, short w, short h,
         unsigned short color) {
-    // rudimentary clipping (drawChar w/big text requires this)
-    if ((x >= _width) || (y >= _height))
+    TFT_STAT_PRIM(FILLRECT);
+
+    if (!tft_clipRect(&x, &y, &w, &h))
+        return;
+    tft_window(x, y, x+w-1, y+h-1);
+    tft_sendColor(color, (unsigned long)w * h);
+}
+
+/**
+ *  Limits drawing to the rectangle with top-left vertex (x, y), width w and
+ *  height h, within the current clip rectangle, until the matching
+ *  tft_popClip(). Every drawing function, including tft_setWindow()
+ *  streams, sends only the pixels inside it.
+ *
+ *  Clips nest up to TFT_CLIP_DEPTH (8) deep; pushes beyond that are
+ *  ignored, along with their pops.
+ *
+ *  Example:
+ *
+ *      // a gauge whose needle must not spill out of its 60x60 box
+ *      tft_pushClip(100, 40, 60, 60);
+ *      tft_drawLine(130, 70, nx, ny, ILI9340_RED);
+ *      tft_popClip();
+ */
+void tft_pushClip(short x, short y, short w, short h) {
+    if (clip_depth == TFT_CLIP_DEPTH) {
+        clip_lost++;
         return;
-    if (x + w - 1 >= _width)
-        w = _width  - x;
-    if (y + h - 1 >= _height)
-        h = _height - y;
+    }
+    clip_stack[clip_depth++] = clip;
+    if (!tft_clipRect(&x, &y, &w, &h)) {
+        x = clip.x0;    // empty: nothing is drawn until the pop
+        y = clip.y0;
+        w = 0;
+        h = 0;
+    }
+    clip.x0 = x;
+    clip.y0 = y;
+    clip.x1 = x + w - 1;
+    clip.y1 = y + h - 1;
+    _clip_x0 = clip.x0 - clip.ox;
+    _clip_y0 = clip.y0 - clip.oy;
+    _clip_x1 = clip.x1 - clip.ox;
+    _clip_y1 = clip.y1 - clip.oy;
+}
 
-    tft_setAddrWindow(x, y, x+w-1, y+h-1);
+/**
+ *  Like tft_pushClip(), but also moves the origin to (x, y), so that
+ *  drawing until the matching tft_popClip() uses coordinates relative to
+ *  the rectangle's top left corner.
+ *
+ *  Example:
+ *
+ *      // a list panel at (20, 60), scrolled down by `scroll` pixels
+ *      tft_pushViewport(20, 60, 200, 120);
+ *      for (i = 0; i < n; i++)
+ *          tft_drawText(2, i * 10 - scroll, items[i], fg, bg, 1);
+ *      tft_popClip();
+ */
+void tft_pushViewport(short x, short y, short w, short h) {
+    short ox = x + clip.ox, oy = y + clip.oy;
 
-    _dc_high();
-    _cs_low();
-    for(y = h; y > 0; y--) {
-        for(x = w; x > 0; x--) {
-            tft_spiwrite16(color);
-        }
+    tft_pushClip(x, y, w, h);
+    if (clip_lost)
+        return;
+    clip.ox = ox;
+    clip.oy = oy;
+    _clip_x0 = clip.x0 - ox;
+    _clip_y0 = clip.y0 - oy;
+    _clip_x1 = clip.x1 - ox;
+    _clip_y1 = clip.y1 - oy;
+}
+
+/**
+ *  Restores the clip rectangle and origin in effect before the last
+ *  tft_pushClip() or tft_pushViewport().
+ */
+void tft_popClip(void) {
+    if (clip_lost) {
+        clip_lost--;
+        return;
     }
-    _cs_high();
+    if (!clip_depth)
+        return;
+    clip = clip_stack[--clip_depth];
+    _clip_x0 = clip.x0 - clip.ox;
+    _clip_y0 = clip.y0 - clip.oy;
+    _clip_x1 = clip.x1 - clip.ox;
+    _clip_y1 = clip.y1 - clip.oy;
 }
 
 /**
- * Fills the entire screen with the given color.
+ *  Empties the clip stack, so that drawing covers the whole screen with
+ *  the origin at its top left corner. tft_setRotation() does this.
+ */
+void tft_resetClip(void) {
+    clip_depth = 0;
+    clip_lost = 0;
+    clip.x0 = 0;
+    clip.y0 = 0;
+    clip.x1 = _width - 1;
+    clip.y1 = _height - 1;
+    clip.ox = 0;
+    clip.oy = 0;
+    _clip_x0 = 0;
+    _clip_y0 = 0;
+    _clip_x1 = clip.x1;
+    _clip_y1 = clip.y1;
+}
+
+/**
+ * Fills the entire screen (or clip rectangle, if smaller) with the given
+ * color.
  */
 void tft_fillScreen(unsigned short color) {
-    tft_fillRect(0, 0, _width, _height, color);
+    tft_fillRect(_clip_x0, _clip_y0, _clip_x1 - _clip_x0 + 1,
+                 _clip_y1 - _clip_y0 + 1, color);
 }
 
 /**
@@ -467,6 +966,7 @@ inline unsigned short tft_Color565(unsigned char r, unsigned char g, unsigned ch
 void tft_setRotation(unsigned char m) {
     unsigned char rotation;
     tft_writecommand(ILI9340_MADCTL);
+    win_valid = 0;  // the address windows are relative to the old rotation
     rotation = m % 4; // can't be higher than 3
     switch (rotation) {
         case 0:
@@ -490,88 +990,44 @@ void tft_setRotation(unsigned char m) {
             _height = ILI9340_TFTWIDTH;
             break;
     }
+    tft_resetClip();
 }
 
-static void delay_ms(unsigned long i){
-    /* Create a software delay about i ms long
-     * Parameters:
-     *      i:  equal to number of milliseconds for delay
-     * Returns: Nothing
-     * Note: Uses Core Timer. Core Timer is cleared at the initialiazion of
-     *      this function. So, applications sensitive to the Core Timer are going
-     *      to be affected
-     */
-    unsigned int j;
-    j = (_pbclk / 2000) * i;
-    WriteCoreTimer(0);
-    while (ReadCoreTimer() < j) { ; }
-}
-
-//static void delay_us(unsigned long i){
-//    /* Create a software delay about i us long
-//     * Parameters:
-//     *      i:  equal to number of microseconds for delay
-//     * Returns: Nothing
-//     * Note: Uses Core Timer. Core Timer is cleared at the initialiazion of
-//     *      this function. So, applications sensitive to the Core Timer are going
-//     *      to be affected
-//     */
-//    unsigned int j;
-//    j = dTime_us * i;
-//    WriteCoreTimer(0);
-//    while (ReadCoreTimer() < j);
-//}
+/**
+ *  Defines the vertical scrolling area: the first `top` and last `bottom`
+ *  lines of the panel's 320 stay fixed, and the lines in between scroll
+ *  with tft_scrollTo().
+ *
+ *  Lines are counted along the long side of the panel, i.e. down the
+ *  screen in rotation 0 (in landscape rotations the area scrolls
+ *  sideways). Use tft_setScrollArea(0, 0) and tft_scrollTo(0) to return
+ *  to normal, unscrolled display.
+ */
+void tft_setScrollArea(short top, short bottom) {
+    tft_beginWrite();
+    tft_writecommand(ILI9340_VSCRDEF);
+    tft_senddata16(top);
+    tft_senddata16(ILI9340_TFTHEIGHT - top - bottom);
+    tft_senddata16(bottom);
+    tft_endWrite();
+}
+
+/**
+ *  Scrolls the area set by tft_setScrollArea() so that frame memory line
+ *  `line` is shown at the top of that area. `line` must lie inside the
+ *  area; the lines that follow wrap around within it.
+ *
+ *  Only the display is affected: drawing still addresses frame memory, so
+ *  scrolling never costs more than this one command.
+ */
+void tft_scrollTo(short line) {
+    tft_beginWrite();
+    tft_writecommand(ILI9340_VSCRSADD);
+    tft_senddata16(line);
+    tft_endWrite();
+}
 
 //void tft_invertDisplay(boolean i) {
 //  writecommand(i ? ILI9340_INVON : ILI9340_INVOFF);
 //}
 
-
-////////// stuff not actively being used, but kept for posterity
-
-
-//unsigned char tft_spiread(void) {
-//  unsigned char r = 0;
-//
-//  /*
-//   * ADD SPI INTERFACE CODE -----------------------------------------------&**************************
-//  */
-//  //Serial.print("read: 0x"); Serial.print(r, HEX);
-//
-//  return r;
-//}
-
-// unsigned char tft_readdata(void) {
-//   unsigned char r;
-//   _dc_high();
-//   _cs_low();
-//   r = tft_spiread();
-//   _cs_high();
-//   return r;
-//
-//}
-//
-//
-// unsigned char tft_readcommand8(unsigned char c) {
-//     _dc_low();
-////     _sclk = 0;
-//     _cs_low();
-//     tft_spiwrite8(c);
-//
-//     _dc_high();
-//     unsigned char r = tft_spiread();
-//     _cs_high();
-//     return r;
-//
-//   /*
-//   digitalWrite(_dc, LOW);
-//   digitalWrite(_sclk, LOW);
-//   digitalWrite(_cs, LOW);
-//   spiwrite(c);
-//
-//   digitalWrite(_dc, HIGH);
-//   unsigned char r = spiread();
-//   digitalWrite(_cs, HIGH);
-//   return r;
-//    */
-//}
@@ -38,6 +38,10 @@
 
 extern unsigned short _width, _height;
 
+// Clip rectangle (inclusive), relative to the current origin; see
+// tft_pushClip()
+extern short _clip_x0, _clip_y0, _clip_x1, _clip_y1;
+
 // Predefined colors (16 bits, 5-6-5 RGB)
 #define	ILI9340_BLACK   0x0000
 #define	ILI9340_BLUE    0x001F
@@ -49,6 +53,8 @@ extern unsigned short _width, _height;
 #define ILI9340_WHITE   0xFFFF
 
 void tft_init();
+void tft_initStart(void);
+int tft_initPoll(void);
 void tft_drawPixel(short x, short y, unsigned short color);
 void tft_drawFastVLine(short x, short y, short h, unsigned short color);
 void tft_drawFastHLine(short x, short y, short w, unsigned short color);
@@ -56,5 +62,21 @@ void tft_fillScreen(unsigned short color);
 void tft_fillRect(short x, short y, short w, short h, unsigned short color);
 unsigned short tft_Color565(unsigned char r, unsigned char g, unsigned char b);
 void tft_setRotation(unsigned char m);
+void tft_setScrollArea(short top, short bottom);
+void tft_scrollTo(short line);
+
+void tft_pushClip(short x, short y, short w, short h);
+void tft_pushViewport(short x, short y, short w, short h);
+void tft_popClip(void);
+void tft_resetClip(void);
+
+void tft_beginWrite(void);
+void tft_setWindow(short x0, short y0, short x1, short y1);
+void tft_pushPixels(const unsigned short *buf, unsigned long n);
+void tft_pushColorN(unsigned short color, unsigned long n);
+void tft_endWrite(void);
+
+void tft_readRect(short x, short y, short w, short h, unsigned short *buf);
+unsigned short tft_readPixel(short x, short y);
 
 #endif
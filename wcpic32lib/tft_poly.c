@@ -0,0 +1,173 @@
+/*
+ *  @file   tft_poly.c
+ *
+ *  @brief  Filled polygons for the TFT, drawn a scanline at a time from a
+ *          sorted edge table.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include "tft_poly.h"
+#include "tft_master.h"
+#include "private/tft_counters.h"
+#include "private/tft_edge.h"
+
+#ifndef TFT_POLY_MAX_POINTS
+#define TFT_POLY_MAX_POINTS 32
+#endif
+
+// A non-horizontal edge from (x0, y0) down to (x1, y1), covering
+// scanlines y0 to y1 - 1
+struct edge {
+    short y0, y1;
+    short x0, x1;
+    struct tft_edge s;  // stepper, while the edge is active
+    signed char dir;    // 1 if the edge runs down, -1 if up
+};
+
+static struct edge edges[TFT_POLY_MAX_POINTS];
+static unsigned char order[TFT_POLY_MAX_POINTS];   // edges by y0
+static unsigned char active[TFT_POLY_MAX_POINTS];  // edges on the scanline,
+                                                   // left to right
+
+/**
+ *  Fills the polygon with the n vertices points[0..n-1] in the given
+ *  color, using the non-zero winding rule. The polygon is closed
+ *  automatically and may be concave or self-intersecting.
+ *
+ *  Example:
+ *
+ *      // an arrow pointing right
+ *      static const struct tft_point arrow[] = {
+ *          { 0, 10 }, { 30, 10 }, { 30, 0 }, { 50, 20 },
+ *          { 30, 40 }, { 30, 30 }, { 0, 30 }
+ *      };
+ *      tft_fillPolygon(arrow, 7, ILI9340_GREEN);
+ */
+void tft_fillPolygon(const struct tft_point *points, short n,
+                     unsigned short color) {
+    tft_fillPolygon2(points, n, color, TFT_NONZERO);
+}
+
+/**
+ *  Fills the polygon with the n vertices points[0..n-1] in the given
+ *  color, using fill rule `rule` (TFT_NONZERO or TFT_EVENODD) to decide
+ *  which parts of a self-intersecting polygon are inside.
+ *
+ *  Example:
+ *
+ *      // a five-pointed star with a hollow center
+ *      static const struct tft_point star[] = {
+ *          { 50, 0 }, { 79, 90 }, { 2, 34 }, { 98, 34 }, { 21, 90 }
+ *      };
+ *      tft_fillPolygon2(star, 5, ILI9340_YELLOW, TFT_EVENODD);
+ */
+void tft_fillPolygon2(const struct tft_point *points, short n,
+                      unsigned short color, unsigned char rule) {
+    const struct tft_point *a, *b;
+    struct edge *e;
+    short i, j, k, ne, nact, next, ymin, ymax, xs, xe, ps, pe;
+    int wind, y, y1;   // int, so the scanline bounds can't wrap
+    TFT_STAT_PRIM(POLYGON);
+
+    if ((n < 3) || (n > TFT_POLY_MAX_POINTS))
+        return;
+
+    // Build the edge table, sorted by first scanline
+    ne = 0;
+    ymin = 0x7FFF;
+    ymax = -0x8000;
+    for (i = 0; i < n; i++) {
+        a = &points[i];
+        b = &points[(i + 1 < n) ? i + 1 : 0];
+        if (a->y == b->y)
+            continue;
+        e = &edges[ne];
+        if (a->y < b->y) {
+            e->dir = 1;
+        } else {
+            e->dir = -1;
+            a = b;
+            b = &points[i];
+        }
+        e->y0 = a->y;
+        e->y1 = b->y;
+        e->x0 = a->x;
+        e->x1 = b->x;
+        for (j = ne; (j > 0) && (edges[order[j - 1]].y0 > e->y0); j--)
+            order[j] = order[j - 1];
+        order[j] = ne++;
+        if (e->y0 < ymin)
+            ymin = e->y0;
+        if (e->y1 > ymax)
+            ymax = e->y1;
+    }
+    if (ne == 0)    // every edge is horizontal: nothing to fill
+        return;
+
+    y = (ymin < _clip_y0) ? _clip_y0 : ymin;
+    y1 = (ymax - 1 > _clip_y1) ? _clip_y1 : ymax - 1;
+    nact = 0;
+    next = 0;
+    tft_beginWrite();
+    for (; y <= y1; y++) {
+        // Drop the edges that have ended
+        for (i = j = 0; i < nact; i++) {
+            if (edges[active[i]].y1 > y)
+                active[j++] = active[i];
+        }
+        nact = j;
+
+        // Add the edges that start here (or above, on the first scanline)
+        for (; (next < ne) && (edges[order[next]].y0 <= y); next++) {
+            e = &edges[order[next]];
+            if (e->y1 <= y)
+                continue;
+            tft_edgeStart(&e->s, e->x0, e->y0, e->x1, e->y1, y);
+            active[nact++] = order[next];
+        }
+
+        // Sort left to right; the order barely changes between scanlines
+        for (i = 1; i < nact; i++) {
+            k = active[i];
+            for (j = i; (j > 0) && (edges[active[j - 1]].s.x > edges[k].s.x); j--)
+                active[j] = active[j - 1];
+            active[j] = k;
+        }
+
+        // Send the inside spans, joining those that touch
+        ps = 0;
+        pe = -1;
+        wind = 0;
+        xs = 0;
+        for (i = 0; i < nact; i++) {
+            e = &edges[active[i]];
+            if (wind == 0)
+                xs = e->s.x;
+            if (rule == TFT_EVENODD)
+                wind ^= 1;
+            else
+                wind += e->dir;
+            if (wind != 0)
+                continue;
+            xe = e->s.x - 1;
+            if (xe < xs)
+                continue;
+            if ((pe < ps) || (xs > pe + 1)) {
+                if (pe >= ps)
+                    tft_drawFastHLine(ps, y, pe - ps + 1, color);
+                ps = xs;
+            }
+            pe = xe;
+        }
+        if (pe >= ps)
+            tft_drawFastHLine(ps, y, pe - ps + 1, color);
+
+        // Step to the next scanline
+        for (i = 0; i < nact; i++)
+            tft_edgeStep(&edges[active[i]].s);
+    }
+    tft_endWrite();
+}
@@ -0,0 +1,39 @@
+#ifndef TFT_POLY_H
+#define TFT_POLY_H
+
+/**
+ *  @file   tft_poly.h
+ *
+ *  @brief  Filled polygons for the TFT, drawn a scanline at a time from a
+ *          sorted edge table.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *          Each scanline goes out as one horizontal span per run of
+ *          inside pixels, so a polygon never draws a pixel twice. Pixel
+ *          (x, y) is filled when the point (x, y) is inside the polygon;
+ *          points on a left or top edge count as inside and points on a
+ *          right or bottom edge don't, so polygons that share an edge
+ *          neither overlap nor leave a gap.
+ *
+ *          Polygons may have up to TFT_POLY_MAX_POINTS vertices (default
+ *          32), which may be changed by defining it when building the
+ *          library.
+ *
+ *  @author Jeff Lutgen
+ */
+
+struct tft_point {
+    short x, y;
+};
+
+// Fill rules
+#define TFT_NONZERO     0   // inside if the edges wind around the point
+#define TFT_EVENODD     1   // inside if a ray crosses an odd number of edges
+
+void tft_fillPolygon(const struct tft_point *points, short n,
+                     unsigned short color);
+void tft_fillPolygon2(const struct tft_point *points, short n,
+                      unsigned short color, unsigned char rule);
+
+#endif // TFT_POLY_H
@@ -0,0 +1,83 @@
+/*
+ *  @file   tft_stats.c
+ *
+ *  @brief  Per-primitive performance counters for the TFT library.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include <stdio.h>
+#include "private/tft_counters.h"
+#include "tft_stats.h"
+#include "timebase.h"
+#include "uart.h"
+
+#ifdef TFT_STATS
+
+struct tft_counters _tft_counters[TFT_STAT_COUNT];
+unsigned char _tft_stat_prim, _tft_stat_depth;
+
+static const char *const names[TFT_STAT_COUNT] = {
+    "(other)", "drawPixel", "drawFastHLine", "drawFastVLine", "fillRect",
+    "pushPixels", "drawLine", "drawRect", "drawCircle", "fillCircle",
+    "drawRoundRect", "fillRoundRect", "drawTriangle", "fillTriangle",
+    "drawBitmap", "drawChar", "drawText", "fillPolygon", "gradient",
+    "chartAdd"
+};
+
+/**
+ *  Prints the counters as a table via uart_write(), skipping primitives
+ *  that haven't been called. Wait times are in microseconds.
+ *
+ *  Example:
+ *
+ *      tft_stats_reset();
+ *      draw_screen();
+ *      tft_stats_dump();
+ */
+void tft_stats_dump(void) {
+    char line[100];
+    unsigned char i;
+    const struct tft_counters *c;
+
+    uart_write("primitive          calls     pixels      words"
+               "  windows    modes  wait us\r\n");
+    for (i = 0; i < TFT_STAT_COUNT; i++) {
+        c = &_tft_counters[i];
+        if ((c->calls == 0) && (c->words == 0))
+            continue;
+        sprintf(line, "%-14s %9lu %10lu %10lu %8lu %8lu %8lu\r\n", names[i],
+                c->calls, c->pixels, c->words, c->windows, c->modes,
+                (unsigned long)ticks_to_us(c->wait));
+        uart_write(line);
+    }
+}
+
+/**
+ *  Zeroes all the counters.
+ */
+void tft_stats_reset(void) {
+    unsigned char i;
+
+    for (i = 0; i < TFT_STAT_COUNT; i++) {
+        _tft_counters[i].calls = 0;
+        _tft_counters[i].pixels = 0;
+        _tft_counters[i].words = 0;
+        _tft_counters[i].windows = 0;
+        _tft_counters[i].modes = 0;
+        _tft_counters[i].wait = 0;
+    }
+}
+
+#else
+
+void tft_stats_dump(void) {
+    uart_write("TFT stats not compiled in (build wcpic32lib with STATS=1)\r\n");
+}
+
+void tft_stats_reset(void) {
+}
+
+#endif // TFT_STATS
@@ -0,0 +1,27 @@
+#ifndef TFT_STATS_H
+#define TFT_STATS_H
+
+/**
+ *  @file   tft_stats.h
+ *
+ *  @brief  Per-primitive performance counters for the TFT library.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *          The counters are only kept when the library is built with
+ *          TFT_STATS defined (make clean all STATS=1); otherwise the
+ *          instrumentation compiles to nothing, and tft_stats_dump() just
+ *          says so.
+ *
+ *          For each primitive (outermost calls only, so the lines drawn by
+ *          tft_drawRect() count towards the rectangle), the counters record
+ *          calls, pixels written, SPI frames queued, address window setups,
+ *          SPI frame size switches, and time spent waiting on SPI1.
+ *
+ *  @author Jeff Lutgen
+ */
+
+void tft_stats_dump(void);
+void tft_stats_reset(void);
+
+#endif // TFT_STATS_H
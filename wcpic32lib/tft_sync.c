@@ -0,0 +1,151 @@
+/*
+ *  @file   tft_sync.c
+ *
+ *  @brief  Tear-free frame pacing for the TFT, using the display's
+ *          tearing effect (TE) output and frame rate control.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include <stdlib.h>
+#include <xc.h>
+#include <sys/attribs.h>        // For __ISR macro
+#include "private/common.h"
+#include "private/tft_registers.h"
+#include "private/tft_spi.h"
+#include "timebase.h"
+#include "tft_sync.h"
+
+#ifndef TFT_TE_READ
+#define TFT_TE_READ()   (PORTBbits.RB7)
+#endif
+
+// Frame rates (Hz) for FRMCTR1 RTNA values 0x10..0x1F, with DIVA = 0
+static const unsigned char frame_rates[16] = {
+    119, 112, 106, 100, 95, 90, 86, 83, 79, 76, 73, 70, 68, 65, 63, 61
+};
+
+static volatile unsigned long frames;
+static volatile unsigned long long last_edge, period;
+
+static unsigned long frames_seen;       // value of frames at the last wait
+static unsigned long long last_wait;    // time the last wait returned
+static unsigned long busy, worst, missed;
+
+// Records a TE rising edge.
+static void tft_syncEdge(void) {
+    unsigned long long now = time_ticks();
+
+    if (frames)     // the first edge only starts the first period
+        period = now - last_edge;
+    last_edge = now;
+    frames++;
+}
+
+#ifndef TFT_SYNC_POLLED
+void __ISR(_EXTERNAL_0_VECTOR, IPL4SOFT) tft_syncHandler(void) {
+    INTClearFlag(INT_INT0);
+    tft_syncEdge();
+}
+#endif
+
+/**
+ *  Turns on the display's TE output (vertical blanking only) and starts
+ *  watching it on RB7.
+ */
+void tft_syncInit(void) {
+    static const unsigned char vblank_only = 0x00;
+
+    TRISBSET = 1 << 7;
+    tft_command(ILI9340_TEON, &vblank_only, 1);
+
+    frames = frames_seen = missed = worst = 0;
+    last_wait = last_edge = time_ticks();
+#ifndef TFT_SYNC_POLLED
+    INTCONSET = _INTCON_INT0EP_MASK;    // rising edge
+    INTSetVectorPriority(INT_EXTERNAL_0_VECTOR, INT_PRIORITY_LEVEL_4);
+    INTSetVectorSubPriority(INT_EXTERNAL_0_VECTOR, INT_SUB_PRIORITY_LEVEL_0);
+    INTClearFlag(INT_INT0);
+    INTEnable(INT_INT0, INT_ENABLED);
+#endif
+}
+
+/**
+ *  Sets the display's refresh rate to the supported rate (61 to 119 Hz)
+ *  closest to `hz`, and returns that rate. The power-on rate is 79 Hz.
+ *
+ *  A lower rate leaves more time per frame for drawing; a rate that is a
+ *  multiple of the animation's frame rate gives the smoothest motion.
+ */
+unsigned char tft_setFrameRate(unsigned char hz) {
+    unsigned char args[2], i, best = 0;
+
+    for (i = 1; i < 16; i++) {
+        if (abs(frame_rates[i] - hz) < abs(frame_rates[best] - hz))
+            best = i;
+    }
+    args[0] = 0x00;         // DIVA: oscillator / 1
+    args[1] = 0x10 + best;  // RTNA: clocks per line
+    tft_command(ILI9340_FRMCTR1, args, 2);
+    return frame_rates[best];
+}
+
+/**
+ *  Waits for the start of the next vertical blanking interval, and updates
+ *  the frame statistics. If drawing since the previous call took longer
+ *  than a frame, the frames that went by are counted as missed.
+ *
+ *  Example:
+ *
+ *      tft_syncInit();
+ *      tft_setFrameRate(60);
+ *      while (1) {
+ *          tft_waitVSync();
+ *          draw_gauge();       // should take well under 1/60 s
+ *      }
+ */
+void tft_waitVSync(void) {
+    unsigned long long now = time_ticks();
+    unsigned long seen;
+#ifdef TFT_SYNC_POLLED
+    unsigned long n;
+
+    // Nothing counts the pulses that went by while drawing, so work them
+    // out from the frame period.
+    if (period) {
+        n = (now - last_edge) / period;
+        frames += n;
+        last_edge += n * period;
+    }
+#endif
+    seen = frames;
+
+    busy = ticks_to_us(now - last_wait);
+    if (busy > worst)
+        worst = busy;
+    missed += seen - frames_seen;
+
+#ifdef TFT_SYNC_POLLED
+    while (TFT_TE_READ()) { ; }     // finish any pulse in progress
+    while (!TFT_TE_READ()) { ; }
+    tft_syncEdge();
+#else
+    while (frames == seen) { ; }
+#endif
+
+    frames_seen = frames;
+    last_wait = time_ticks();
+}
+
+/**
+ *  Copies the current frame statistics to `stats`.
+ */
+void tft_frameStats(struct tft_frame_stats *stats) {
+    stats->frames = frames;
+    stats->period_us = ticks_to_us(period);
+    stats->busy_us = busy;
+    stats->worst_us = worst;
+    stats->missed = missed;
+}
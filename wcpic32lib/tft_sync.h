@@ -0,0 +1,41 @@
+#ifndef TFT_SYNC_H
+#define TFT_SYNC_H
+
+/**
+ *  @file   tft_sync.h
+ *
+ *  @brief  Tear-free frame pacing for the TFT, using the display's
+ *          tearing effect (TE) output and frame rate control.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *          Connect the TFT's TE output to RB7 (pin 16, INT0). The display
+ *          raises TE at the start of each vertical blanking interval;
+ *          tft_waitVSync() returns just after that, so drawing that starts
+ *          then stays ahead of the panel refresh. Requires multi-vectored
+ *          interrupts to be enabled, and the timebase (timebase.h).
+ *
+ *          Building the library with TFT_SYNC_POLLED defined polls the TE
+ *          pin instead of using INT0; frames that go by between waits are
+ *          then worked out from the frame period. TFT_TE_READ() (normally
+ *          reading RB7) may also be redefined, e.g. to a function driven by
+ *          a host test stub (see tests/test_sync.c).
+ *
+ *  @author Jeff Lutgen
+ */
+
+// Frame timing gathered by tft_waitVSync(), in microseconds
+struct tft_frame_stats {
+    unsigned long frames;       // TE pulses seen since tft_syncInit()
+    unsigned long period_us;    // time between the last two TE pulses
+    unsigned long busy_us;      // time between the last two waits
+    unsigned long worst_us;     // longest busy_us so far
+    unsigned long missed;       // frames skipped because drawing overran
+};
+
+void tft_syncInit(void);
+unsigned char tft_setFrameRate(unsigned char hz);
+void tft_waitVSync(void);
+void tft_frameStats(struct tft_frame_stats *stats);
+
+#endif // TFT_SYNC_H
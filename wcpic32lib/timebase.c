@@ -0,0 +1,155 @@
+/*
+ *  @file   timebase.c
+ *
+ *  @brief  A monotonic 64-bit timebase built on the core timer, with
+ *          deadline helpers and delays.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *  @author Jeff Lutgen
+ */
+
+#include <xc.h>
+#include <sys/attribs.h>        // For __ISR macro
+#include "private/common.h"
+#include "timebase.h"
+
+// Upper 32 bits of the tick count, bumped each time the core timer wraps
+static volatile unsigned long tick_hi;
+
+static unsigned long tick_rate;    // core timer ticks per second
+
+/*
+ *  The compare register stays at 0, so this runs just after each wrap of
+ *  the core timer. Writing the compare register acknowledges the
+ *  interrupt.
+ */
+void __ISR(_CORE_TIMER_VECTOR, IPL6SOFT) timebase_handler(void) {
+    _CP0_SET_COMPARE(0);
+    mCTClearIntFlag();
+    tick_hi++;
+}
+
+/**
+ *  Starts the timebase. Called by wclib_init(), so applications don't
+ *  normally need to call it.
+ */
+void timebase_init(void) {
+    tick_rate = _sysclk / 2;
+
+    _CP0_SET_COMPARE(0);
+    INTSetVectorPriority(INT_CORE_TIMER_VECTOR, INT_PRIORITY_LEVEL_6);
+    INTSetVectorSubPriority(INT_CORE_TIMER_VECTOR, INT_SUB_PRIORITY_LEVEL_0);
+    INTClearFlag(INT_CT);
+    INTEnable(INT_CT, INT_ENABLED);
+}
+
+/**
+ *  Returns the number of core timer ticks (SYSCLK/2) since reset.
+ */
+unsigned long long time_ticks(void) {
+    unsigned long hi, lo;
+    unsigned int status;
+
+    status = INTDisableInterrupts();
+    hi = tick_hi;
+    lo = ReadCoreTimer();
+    // A wrap whose interrupt hasn't been serviced yet (we may be running
+    // at a higher priority, or interrupts may be off)
+    if (IFS0bits.CTIF && (lo < 0x80000000))
+        hi++;
+    INTRestoreInterrupts(status);
+
+    return ((unsigned long long)hi << 32) | lo;
+}
+
+// Converts a tick count to units of 1/per_s seconds, rounding down. Split
+// into whole seconds and the rest so the product can't overflow.
+static unsigned long long ticks_to(unsigned long long ticks,
+                                   unsigned long per_s) {
+    return ticks / tick_rate * per_s +
+           ticks % tick_rate * per_s / tick_rate;
+}
+
+// Converts n units of 1/per_s seconds to ticks, rounding up
+static unsigned long long ticks_from(unsigned long n, unsigned long per_s) {
+    return ((unsigned long long)n * tick_rate + per_s - 1) / per_s;
+}
+
+/**
+ *  Returns the number of microseconds since reset.
+ */
+unsigned long long time_us(void) {
+    return ticks_to(time_ticks(), 1000000);
+}
+
+/**
+ *  Converts a number of core timer ticks (e.g. the difference of two
+ *  time_ticks() values) to microseconds, rounding down.
+ */
+unsigned long long ticks_to_us(unsigned long long ticks) {
+    return ticks_to(ticks, 1000000);
+}
+
+/**
+ *  Returns the number of milliseconds since reset. Wraps after about 49
+ *  days; compare times by subtracting them.
+ */
+unsigned long time_ms(void) {
+    return ticks_to(time_ticks(), 1000);
+}
+
+/**
+ *  Returns a deadline `us` microseconds from now, for use with
+ *  deadline_passed().
+ *
+ *  Example:
+ *
+ *      unsigned long long timeout = deadline_us(500);
+ *      while (!uart_ready()) {
+ *          if (deadline_passed(timeout))
+ *              return -1;
+ *      }
+ */
+unsigned long long deadline_us(unsigned long us) {
+    return time_ticks() + ticks_from(us, 1000000);
+}
+
+/**
+ *  Returns a deadline `ms` milliseconds from now, for use with
+ *  deadline_passed().
+ *
+ *  Example (in a protothread):
+ *
+ *      static unsigned long long next;
+ *      next = deadline_ms(100);
+ *      PT_WAIT_UNTIL(pt, deadline_passed(next));
+ */
+unsigned long long deadline_ms(unsigned long ms) {
+    return time_ticks() + ticks_from(ms, 1000);
+}
+
+/**
+ *  Returns nonzero if the given deadline has been reached.
+ */
+int deadline_passed(unsigned long long deadline) {
+    return time_ticks() >= deadline;
+}
+
+/**
+ *  Delays for at least the given number of microseconds.
+ */
+void delay_us(unsigned long us) {
+    unsigned long long deadline = deadline_us(us);
+
+    while (!deadline_passed(deadline)) { ; }
+}
+
+/**
+ *  Delays for at least the given number of milliseconds.
+ */
+void delay_ms(unsigned long ms) {
+    unsigned long long deadline = deadline_ms(ms);
+
+    while (!deadline_passed(deadline)) { ; }
+}
@@ -0,0 +1,35 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+/**
+ *  @file   timebase.h
+ *
+ *  @brief  A monotonic 64-bit timebase built on the core timer, with
+ *          deadline helpers and delays.
+ *
+ *          Intended for use with the PIC32MX250F128B.
+ *
+ *          The core timer counts at SYSCLK/2 and is never written, so other
+ *          code may keep reading it directly. Its compare interrupt extends
+ *          it to 64 bits, which requires multi-vectored interrupts to be
+ *          enabled (INTEnableSystemMultiVectoredInt()); without them the
+ *          time is still correct for one wrap of the 32-bit counter (about
+ *          214 s at 40 MHz).
+ *
+ *  @author Jeff Lutgen
+ */
+
+void timebase_init(void);
+unsigned long long time_ticks(void);
+unsigned long long time_us(void);
+unsigned long long ticks_to_us(unsigned long long ticks);
+unsigned long time_ms(void);
+
+unsigned long long deadline_us(unsigned long us);
+unsigned long long deadline_ms(unsigned long ms);
+int deadline_passed(unsigned long long deadline);
+
+void delay_us(unsigned long us);
+void delay_ms(unsigned long ms);
+
+#endif // TIMEBASE_H
@@ -10,22 +10,15 @@
 
 #include <xc.h>
 #include "private/common.h"
+#include "timebase.h"
 
 /**
  *  Delays for a given number of milliseconds.
  *
- *  Uses a crude implementation, but good enough for many use cases. Accuracy
- *  of this routine will suffer if significant time is being spent in interrupt
- *  service routines. See `delay_ms()` in tft_master.c for a better
- *  implementation that uses the core timer.
- *
- *  Calibrated on a PIC32MX250F128B.
+ *  Kept for existing code; equivalent to `delay_ms()` in timebase.h.
  */
 void delay(int ms) {
-    volatile int j;
-    // magic constant 8920 obtained empirically
-    for (j = 0; j < (_sysclk / 8920) * ms; j++) {
-    }
+    delay_ms(ms);
 }
 
 /**